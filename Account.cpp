@@ -1,11 +1,17 @@
 #include "Account.h"
+#include "RadixSort.h"
+
+// Powers of ten that fit in an int, used for digit counting and prefix tests
+static constexpr int POWERS_OF_TEN[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
 
 // Constructor
 Account::Account() 
- : accountNumber(0), balance(0.0), description("") {}
+ : accountNumber(0), balance(), openingBalance(), description("") {}
 
-Account::Account(int number, const string & desc, double bal)
- : description(desc), balance(bal) {
+Account::Account(int number, const string & desc, Money bal)
+ : description(desc), balance(bal), openingBalance(bal) {
     setAccountNumber(number);
 }
 
@@ -14,122 +20,161 @@ int Account::getAccountNumber() const {
     return accountNumber;
 }
 
-double Account::getBalance() const {
+Money Account::getBalance() const {
     return balance;
 }
 
-string Account::getDescription() const {
+Money Account::getOpeningBalance() const {
+    return openingBalance;
+}
+
+const string &Account::getDescription() const {
     return description;
 }
    
-const vector<Transaction>& Account::getTransactions() const {
+const TransactionStore& Account::getTransactions() const {
+    sortTransactionsIfNeeded();
     return transactions;
 }
 
 // Setters
-void Account::setAccountNumber(int num) {
+Status Account::setAccountNumber(int num) {
     if (num < 1) {
-        cerr << "Invalid Account Number\n";
-        return;
+        diagnose(Status::InvalidAccountNumber, [] { return string("Invalid Account Number"); });
+        return Status::InvalidAccountNumber;
     }
     accountNumber = num;
+    return Status::Ok;
 }
 
-void Account::addTransaction(const Transaction &trans) {
-    if (findTransaction(trans.getId()) != transactions.end()) {
-        cout << "Transaction " << trans.getId() << " already exists" << endl;
-        return;
+Status Account::addTransaction(const Transaction &trans) {
+    if (!transactions.add(trans)) {
+        diagnose(Status::TransactionExists, [&] {
+            return "Transaction " + to_string(trans.getId()) + " already exists";
+        });
+        return Status::TransactionExists;
     }
     // update account balance
-    updateBalance(trans.getAmount() * (trans.getType() == 'C' ? -1 : 1));
-    transactions.push_back(trans);
+    updateBalance(trans.getSignedAmount());
+    if (trans.isDated()) {
+        history.add(trans.getDate(), trans.getSignedAmount());
+    }
+    return Status::Ok;
 }
 
-Transaction Account::removeTransaction(int id) {
-    auto it = findTransaction(id);
-    
-    // Found the transaction
-    if (it != transactions.end()) {
-        Transaction trans = *it;
-        updateBalance(it->getAmount() * (it->getType() == 'D' ? -1 : 1));
-        transactions.erase(it);
-        cout << "Transaction successfully removed!!\n";
-        return trans;
+Status Account::removeTransaction(int id, Transaction & removed) {
+    if (eraseTransaction(id, removed)) {
+        return Status::Ok;
     }
-
-    cerr << "Transaction not found!!\n";
-    return Transaction(-1);
+    diagnose(Status::TransactionNotFound, [] { return string("Transaction not found!!"); });
+    return Status::TransactionNotFound;
 }
 
-vector<Transaction>::iterator Account::findTransaction(int transactionID) {
-    int left = 0;
-    int right = transactions.size() - 1;
-    radixSortTransactions();// sort the vector 
+bool Account::eraseTransaction(int id, Transaction & removed) {
+    // The last transaction moves into the freed position
+    if (!transactions.erase(id, removed)) {
+        return false;
+    }
+    updateBalance(-removed.getSignedAmount());
+    if (removed.isDated()) {
+        history.add(removed.getDate(), -removed.getSignedAmount());
+    }
+    return true;
+}
 
-    // binary search after sorting
-    while (left <= right) {
-        int mid = left + (right - left) / 2;
+bool Account::findTransaction(int transactionID, Transaction & found) const {
+    size_t pos = transactions.find(transactionID);
+    if (pos == TransactionStore::npos) {
+        return false;
+    }
+    found = transactions.at(pos);
+    return true;
+}
 
-        if (transactions[mid].getId() == transactionID) {
-            return transactions.begin() + mid;  // Return iterator pointing to the transaction
-        } else if (transactions[mid].getId() < transactionID) {
-            left = mid + 1;  // Search in the right half
-        } else {
-            right = mid - 1;  // Search in the left half
+void Account::restoreTransactions(TransactionStore && sortedTransactions) {
+    transactions = move(sortedTransactions);
+    history.clear();
+    // The dates come in ID order, not date order, so they go in as one batch
+    vector<pair<int, Money>> dated;
+    const vector<int> & dates = transactions.getDates();
+    for (size_t pos = 0; pos < dates.size(); pos++) {
+        if (dates[pos] != 0) {
+            Money amount = Money::fromCents(transactions.getAmountCents(pos));
+            dated.push_back({dates[pos], transactions.isCredit(pos) ? -amount : amount});
         }
     }
+    history.addAll(dated);
+}
+
+bool Account::hasTransaction(int transactionID) const {
+    return transactions.contains(transactionID);
+}
 
-    return transactions.end();  // Return end() if not found
+void Account::sortTransactionsIfNeeded() const {
+    // Buffers are reused by every sort done on this thread
+    static thread_local TransactionSorter sorter;
+    transactions.sort(sorter);
 }
 
 void Account::radixSortTransactions() {
-    // Find the maximum transaction ID
-    int maxId = 0;
-    for (const auto &trans : transactions) {
-        maxId = max(maxId, trans.getId());
-    }
+    sortTransactionsIfNeeded();
+}
 
-    // Perform counting sort for each digit
-    for (int exp = 1; maxId / exp > 0; exp *= 10) {
-        countingSortByDigit(transactions, exp);
-    }
+void Account::updateBalance(Money amount) {
+    balance += amount;
 }
 
-void Account::countingSortByDigit(vector<Transaction> & transactions, int exp) {
-    int n = transactions.size();
-    vector<Transaction> output(n);
-    int count[10] = {0};
+void Account::setBalance(Money amount) {
+    balance = amount;
+}
 
-    // Count occurrences of digits in the current position
-    for (int i = 0; i < n; i++) {
-        int digit = (transactions[i].getId() / exp) % 10;
-        count[digit]++;
-    }
+void Account::setOpeningBalance(Money amount) {
+    openingBalance = amount;
+}
 
-    // Update count[i] to hold the actual position of digits
-    for (int i = 1; i < 10; i++) {
-        count[i] += count[i - 1];
-    }
+void Account::recordHistory(int date, Money amount) {
+    history.add(date, amount);
+}
 
-    // Build the output array
-    for (int i = n - 1; i >= 0; i--) {
-        int digit = (transactions[i].getId() / exp) % 10;
-        output[count[digit] - 1] = transactions[i];
-        count[digit]--;
-    }
+void Account::recordHistory(const BalanceHistory & below) {
+    history.addHistory(below);
+}
 
-    // Copy the sorted transactions back to the original vector
-    for (int i = 0; i < n; i++) {
-        transactions[i] = output[i];
-    }
+Money Account::getBalanceAsOf(int date) const {
+    // Everything recorded later has not happened yet on that date
+    return balance - (history.total() - history.totalThrough(date));
 }
 
-void Account::updateBalance(double amount) {
-    balance += amount;
+Money Account::getChangeBetween(int fromDate, int toDate) const {
+    return history.totalBetween(fromDate, toDate);
+}
+
+const BalanceHistory &Account::getHistory() const {
+    return history;
 }
 
 bool Account::compAccountNumber(const int otherAccountNum) const {
-    return to_string(otherAccountNum).find(to_string(accountNumber)) == 0;
+    return isPrefix(accountNumber, otherAccountNum);
+}
+
+int Account::countDigits(int number) {
+    int digits = 1;
+    while (digits < 10 && number >= POWERS_OF_TEN[digits]) {
+        digits++;
+    }
+    return digits;
+}
+
+int Account::leadingDigit(int number) {
+    return number / POWERS_OF_TEN[countDigits(number) - 1];
+}
+
+bool Account::isPrefix(int prefix, int number) {
+    if (prefix < 0 || number < 0) {
+        return false;
+    }
+    int shift = countDigits(number) - countDigits(prefix);
+    return shift >= 0 && number / POWERS_OF_TEN[shift] == prefix;
 }
 
 vector<string> split(string& line, char delimiter) {
@@ -159,12 +204,21 @@ void Account::readAccount(istream& in) {
 
     vector<string> parts = split(line, ' ');
     if (parts.size() < 3) {
-        cerr << "Error: Invalid account format in line: " << line << endl;
+        diagnose(Status::InvalidFormat, [&] { return "Error: Invalid account format in line: " + line; });
+        in.setstate(ios::failbit);
         return;
     }
 
+    const string & amount = parts[parts.size() - 1];
+    Money parsedBalance;
+    if (!Money::parse(amount.data(), amount.data() + amount.size(), parsedBalance)) {
+        diagnose(Status::InvalidFormat, [&] { return "Error: Invalid balance in line: " + line; });
+        in.setstate(ios::failbit);
+        return;
+    }
     accountNumber = stoi(parts[0]);
-    balance = stod(parts[parts.size() - 1]);
+    balance = parsedBalance;
+    openingBalance = parsedBalance;
 
     string desc;
     for (int i = 1; i < parts.size() - 2; i++) {
@@ -180,10 +234,11 @@ void Account::printAccount(ostream & out) const {
         << "Balance: " << balance << '\n'
         << "Description: " << description << '\n'
         << "Transactions: \n";
+    sortTransactionsIfNeeded();
     if (transactions.empty()) {
         out << "No transactions found.\n";
     } else {
-        for (const auto &trans : transactions) {
+        for (const Transaction &trans : transactions) {
             out << trans << '\n';
         }
     }
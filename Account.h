@@ -8,6 +8,7 @@
      - Constructors: Default and parameterized constructors
      - Transaction Management: Add, remove, and search transactions
      - Balance Update: Update the account balance
+     - Balance History: Balances as of a date and changes between dates
      - Sorting: Radix sort transactions
      - Stream Operations: Input and output operators for the Account class
 
@@ -19,6 +20,8 @@
 #include <iostream>
 #include <vector>
 #include "Transaction.h"
+#include "TransactionStore.h"
+#include "BalanceHistory.h"
 
 using namespace std;
 
@@ -28,17 +31,29 @@ private:
     /******** Data Members ********/
     int accountNumber;              // Unique account number
     string description;             // Description of the account
-    double balance;                 // Current account balance
-    vector<Transaction> transactions; // List of transactions associated with the account
+    Money balance;                  // Current account balance
+    Money openingBalance;           // Balance before any transaction, as created or read
+    BalanceHistory history;         // Dated postings of the account and, in a tree, its subaccounts
+    mutable TransactionStore transactions;  // Columnar transactions with an ID index; sorted lazily
 
     /******** Private Member Functions ********/
+    void sortTransactionsIfNeeded() const;
+    /*----------------------------------------------------------------------
+    Restore ascending ID order before the transactions are read in order.
+
+    Precondition:  None.
+    Postcondition: transactions is sorted by ID and its index points at
+    the new positions. Does nothing if the list is already sorted.
+    -----------------------------------------------------------------------*/
+
     void readAccount(istream &);
     /*----------------------------------------------------------------------
     Read account details from an input stream.
 
     Precondition:  The input stream 'in' is open and valid.
     Postcondition: Reads the account's data (number, description, balance)
-    from the input stream.
+    from the input stream. A malformed line leaves the account unchanged,
+    reports a diagnostic and sets the stream's failbit.
     -----------------------------------------------------------------------*/
 
     void printAccount(ostream &) const;
@@ -57,54 +72,158 @@ public:
 
     Precondition:  None.
     Postcondition: An Account object is created with default values for
-    accountNumber (0), description (empty string), and balance (0.0).
+    accountNumber (0), description (empty string), balance and opening
+    balance (0).
     -----------------------------------------------------------------------*/
 
-    Account(int accountNumber, const string &description, double balance);
+    Account(int accountNumber, const string &description, Money balance);
     /*----------------------------------------------------------------------
     Construct an Account object with specified values.
 
     Precondition:  accountNumber must be a positive integer, description
-    is a non-empty string, and balance is a valid double.
-    Postcondition: An Account object is initialized with the given values.
+    is a non-empty string.
+    Postcondition: An Account object is initialized with the given values;
+    balance is also the opening balance.
     -----------------------------------------------------------------------*/
 
     /******** Transaction Management ********/
-    void addTransaction(const Transaction &transaction);
+    Status addTransaction(const Transaction &transaction);
     /*----------------------------------------------------------------------
     Add a transaction to the account.
 
     Precondition:  The transaction is valid.
-    Postcondition: The transaction is added to the account's transaction list.
+    Postcondition: The transaction is added to the account's transaction list
+    and Status::Ok is returned, unless its ID is already present; then a
+    diagnostic is reported and Status::TransactionExists is returned. Runs
+    in O(1) average time.
     -----------------------------------------------------------------------*/
 
-    Transaction removeTransaction(int transactionID);
+    Status removeTransaction(int transactionID, Transaction &removed);
     /*----------------------------------------------------------------------
     Remove a transaction by its ID.
 
     Precondition:  transactionID corresponds to an existing transaction.
-    Postcondition: The transaction with the specified ID is removed and
-    returned. If no transaction matches, an error is handled.
+    Postcondition: The transaction with the specified ID is removed, copied
+    into removed, and Status::Ok is returned. If no transaction matches, a
+    diagnostic is reported and Status::TransactionNotFound is returned.
+    The last transaction takes the freed position, so removal is O(1)
+    average time.
+    -----------------------------------------------------------------------*/
+
+    bool eraseTransaction(int transactionID, Transaction &removed);
+    /*----------------------------------------------------------------------
+    Remove a transaction by its ID without reporting a diagnostic.
+
+    Precondition:  None.
+    Postcondition: If the ID is present, the transaction is removed as by
+    removeTransaction, copied into removed, and true is returned.
+    Otherwise nothing changes and false is returned.
     -----------------------------------------------------------------------*/
 
-    vector<Transaction>::iterator findTransaction(int transactionID);
+    bool findTransaction(int transactionID, Transaction &found) const;
     /*----------------------------------------------------------------------
     Find a transaction by its ID.
 
     Precondition:  transactionID is valid.
-    Postcondition: Returns an iterator to the transaction if found, or to
-    transactions.end() if not found.
+    Postcondition: Copies the transaction into found and returns true if
+    it is present; otherwise returns false. Uses the ID index and does not
+    sort.
+    -----------------------------------------------------------------------*/
+
+    void restoreTransactions(TransactionStore &&sortedTransactions);
+    /*----------------------------------------------------------------------
+    Replace the transaction list with one restored from storage.
+
+    Precondition:  sortedTransactions is in ascending ID order without
+    duplicate IDs, and the balance already includes them.
+    Postcondition: The account holds exactly these transactions and its
+    history holds exactly their dated amounts; the balance is not changed.
+    -----------------------------------------------------------------------*/
+
+    bool hasTransaction(int transactionID) const;
+    /*----------------------------------------------------------------------
+    Check whether a transaction ID is present.
+
+    Precondition:  None.
+    Postcondition: Returns true if the account holds a transaction with
+    this ID. Uses the ID index and does not sort.
     -----------------------------------------------------------------------*/
 
     /******** Balance Management ********/
-    void updateBalance(double amount);
+    void updateBalance(Money amount);
     /*----------------------------------------------------------------------
     Update the account balance by adding the specified amount.
 
-    Precondition:  amount is a valid double.
+    Precondition:  None.
     Postcondition: The balance is updated by adding the amount.
     -----------------------------------------------------------------------*/
 
+    void setBalance(Money balance);
+    /*----------------------------------------------------------------------
+    Replace the account balance.
+
+    Precondition:  None.
+    Postcondition: The balance equals the given value. The opening balance
+    is not changed.
+    -----------------------------------------------------------------------*/
+
+    void setOpeningBalance(Money balance);
+    /*----------------------------------------------------------------------
+    Replace the opening balance.
+
+    Precondition:  None.
+    Postcondition: The opening balance equals the given value; the current
+    balance is not changed.
+    -----------------------------------------------------------------------*/
+
+    /******** Balance History ********/
+    void recordHistory(int date, Money amount);
+    /*----------------------------------------------------------------------
+    Record a dated amount that changed the balance without being one of
+    the account's own transactions (a subaccount's posting rolled up).
+
+    Precondition:  Transaction::isValidDate(date), and the balance
+    already includes amount.
+    Postcondition: The history includes amount on date.
+    -----------------------------------------------------------------------*/
+
+    void recordHistory(const BalanceHistory &below);
+    /*----------------------------------------------------------------------
+    Record every dated amount of another history at once (a whole
+    subaccount's history rolled up).
+
+    Precondition:  below is not this account's history, and the balance
+    already includes its amounts.
+    Postcondition: The history includes each amount of below on its date.
+    -----------------------------------------------------------------------*/
+
+    Money getBalanceAsOf(int date) const;
+    /*----------------------------------------------------------------------
+    Get the balance at the end of a day.
+
+    Precondition:  Transaction::isValidDate(date).
+    Postcondition: Returns the balance minus every amount recorded after
+    date, in O(log d). The opening balance and undated transactions count
+    as effective before every date.
+    -----------------------------------------------------------------------*/
+
+    Money getChangeBetween(int fromDate, int toDate) const;
+    /*----------------------------------------------------------------------
+    Get the net change of the balance between two dates, both included.
+
+    Precondition:  Both dates are valid.
+    Postcondition: Returns the total recorded in the range, in O(log d);
+    0 if fromDate > toDate.
+    -----------------------------------------------------------------------*/
+
+    const BalanceHistory &getHistory() const;
+    /*----------------------------------------------------------------------
+    Get the dated postings index.
+
+    Precondition:  None.
+    Postcondition: Returns a constant reference to the history.
+    -----------------------------------------------------------------------*/
+
     /******** Account Number Comparison ********/
     bool compAccountNumber(const int number) const;
     /*----------------------------------------------------------------------
@@ -115,21 +234,40 @@ public:
     otherwise returns false.
     -----------------------------------------------------------------------*/
 
-    /******** Sorting ********/
-    void radixSortTransactions();
+    /******** Digit Helpers ********/
+    static int countDigits(int number);
     /*----------------------------------------------------------------------
-    Perform radix sort on the account's transactions.
+    Count the decimal digits of a number without converting it to a string.
 
-    Precondition:  The transaction list is populated.
-    Postcondition: The transaction list is sorted in ascending order.
+    Precondition:  number >= 0.
+    Postcondition: Returns the number of decimal digits (1 for 0).
     -----------------------------------------------------------------------*/
 
-    void countingSortByDigit(vector<Transaction> &transactions, int digit);
+    static int leadingDigit(int number);
     /*----------------------------------------------------------------------
-    Perform counting sort on the transactions based on a specific digit.
+    Get the most significant decimal digit of a number.
 
-    Precondition:  transactions is non-empty, and digit is a valid index.
-    Postcondition: transactions is sorted based on the specified digit.
+    Precondition:  number >= 0.
+    Postcondition: Returns the first digit of number (0 for 0).
+    -----------------------------------------------------------------------*/
+
+    static bool isPrefix(int prefix, int number);
+    /*----------------------------------------------------------------------
+    Check whether the decimal digits of prefix start the digits of number.
+
+    Precondition:  None.
+    Postcondition: Returns true if to_string(number) starts with
+    to_string(prefix), computed with integer arithmetic only.
+    -----------------------------------------------------------------------*/
+
+    /******** Sorting ********/
+    void radixSortTransactions();
+    /*----------------------------------------------------------------------
+    Perform a base-256 radix sort on the account's transactions.
+
+    Precondition:  The transaction list is populated.
+    Postcondition: The transaction columns are sorted in ascending ID order
+    and the ID index is rebuilt for the new positions.
     -----------------------------------------------------------------------*/
 
     /******** Getters ********/
@@ -141,7 +279,7 @@ public:
     Postcondition: Returns the account number.
     -----------------------------------------------------------------------*/
 
-    double getBalance() const;
+    Money getBalance() const;
     /*----------------------------------------------------------------------
     Get the account balance.
 
@@ -149,7 +287,16 @@ public:
     Postcondition: Returns the account's current balance.
     -----------------------------------------------------------------------*/
 
-    string getDescription() const;
+    Money getOpeningBalance() const;
+    /*----------------------------------------------------------------------
+    Get the balance the account started with.
+
+    Precondition:  None.
+    Postcondition: Returns the opening balance: the account's own balance
+    minus the net amount of its own transactions.
+    -----------------------------------------------------------------------*/
+
+    const string &getDescription() const;
     /*----------------------------------------------------------------------
     Get the account description.
 
@@ -157,21 +304,24 @@ public:
     Postcondition: Returns the account's description.
     -----------------------------------------------------------------------*/
 
-    const vector<Transaction>& getTransactions() const;
+    const TransactionStore& getTransactions() const;
     /*----------------------------------------------------------------------
     Get the list of transactions associated with the account.
 
     Precondition:  None.
-    Postcondition: Returns a constant reference to the transaction list.
+    Postcondition: Returns a constant reference to the transaction store,
+    sorted in ascending ID order.
     -----------------------------------------------------------------------*/
 
     /******** Setters ********/
-    void setAccountNumber(int accountNumber);
+    Status setAccountNumber(int accountNumber);
     /*----------------------------------------------------------------------
     Set the account number.
 
     Precondition:  accountNumber must be a positive integer.
-    Postcondition: Updates the account number.
+    Postcondition: Updates the account number and returns Status::Ok. If
+    accountNumber is not positive, the number is unchanged, a diagnostic
+    is reported and Status::InvalidAccountNumber is returned.
     -----------------------------------------------------------------------*/
 
     /******** Stream Operators ********/
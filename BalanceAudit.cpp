@@ -0,0 +1,82 @@
+#include "BalanceAudit.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define BALANCE_AUDIT_USE_AVX2 1
+#endif
+
+// One transaction at a time, branching on its type
+static int64_t sumScalar(const int64_t * cents, const uint64_t * creditBits, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        if ((creditBits[i / 64] >> (i % 64)) & 1) {
+            sum -= cents[i];
+        } else {
+            sum += cents[i];
+        }
+    }
+    return sum;
+}
+
+// Branch-free: a credit's mask is all ones, and (x ^ -1) + 1 == -x
+static int64_t sumPortable(const int64_t * cents, const uint64_t * creditBits, size_t begin, size_t end) {
+    int64_t sum = 0;
+    size_t i = begin;
+    for (; i + 64 <= end && i % 64 == 0; i += 64) {
+        uint64_t bits = creditBits[i / 64];
+        const int64_t * block = cents + i;
+        for (int j = 0; j < 64; j++) {
+            int64_t mask = -(int64_t)((bits >> j) & 1);
+            sum += (block[j] ^ mask) - mask;
+        }
+    }
+    for (; i < end; i++) {
+        int64_t mask = -(int64_t)((creditBits[i / 64] >> (i % 64)) & 1);
+        sum += (cents[i] ^ mask) - mask;
+    }
+    return sum;
+}
+
+#ifdef BALANCE_AUDIT_USE_AVX2
+__attribute__((target("avx2")))
+static int64_t sumAvx2(const int64_t * cents, const uint64_t * creditBits, size_t count) {
+    // Lane k tests bit k of each group of four credit bits
+    const __m256i lanes = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i total = _mm256_setzero_si256();
+    size_t words = count / 64;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = creditBits[w];
+        const int64_t * block = cents + w * 64;
+        for (int j = 0; j < 64; j += 4) {
+            __m256i flags = _mm256_and_si256(_mm256_set1_epi64x((int64_t)(bits >> j)), lanes);
+            __m256i mask = _mm256_cmpeq_epi64(flags, lanes);
+            __m256i amounts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + j));
+            total = _mm256_add_epi64(total, _mm256_sub_epi64(_mm256_xor_si256(amounts, mask), mask));
+        }
+    }
+    int64_t parts[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(parts), total);
+    return parts[0] + parts[1] + parts[2] + parts[3] + sumPortable(cents, creditBits, words * 64, count);
+}
+#endif
+
+bool vectorKernelUsesAvx2() {
+#ifdef BALANCE_AUDIT_USE_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+int64_t sumSignedCents(const int64_t * cents, const uint64_t * creditBits, size_t count, AuditKernel kernel) {
+    if (kernel == AuditKernel::Scalar) {
+        return sumScalar(cents, creditBits, count);
+    }
+#ifdef BALANCE_AUDIT_USE_AVX2
+    if (vectorKernelUsesAvx2()) {
+        return sumAvx2(cents, creditBits, count);
+    }
+#endif
+    return sumPortable(cents, creditBits, 0, count);
+}
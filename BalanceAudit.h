@@ -0,0 +1,72 @@
+/*-- BalanceAudit.h ----------------------------------------------------------
+
+  This header file defines the results of a balance audit and the kernels
+  that sum transaction amounts for it (see ForestTree::auditBalances).
+
+  An audit recomputes every account's balance from scratch: its opening
+  balance plus the signed sum of its own transactions (debits positive,
+  credits negative, as addTransaction applies them), then the totals of
+  its subaccounts, bottom-up. Both the account's own part and the
+  rolled-up result are compared with the incrementally maintained values.
+
+  The sums run over a TransactionStore's dense amount column and credit
+  bits. The vector kernel negates credits branch-free, four amounts per
+  AVX2 instruction when the processor has AVX2 and in a loop the compiler
+  can vectorize otherwise. The scalar kernel handles one transaction at a
+  time and serves as the baseline.
+
+  Basic operations include:
+     - Kernels: Signed sum of an amount column, scalar or vectorized
+     - Results: Mismatched accounts and audit totals
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Money.h"
+
+using namespace std;
+
+/******** Kernels ********/
+enum class AuditKernel {
+    Scalar,     // One transaction at a time
+    Vector      // Branch-free, several transactions per instruction
+};
+
+int64_t sumSignedCents(const int64_t *cents, const uint64_t *creditBits, size_t count, AuditKernel kernel);
+/*--------------------------------------------------------------------------
+Sum amounts with credits negated.
+
+Precondition:  cents holds count amounts; bit i of creditBits (word i / 64,
+bit i % 64) is set if amount i is a credit.
+Postcondition: Returns the debits minus the credits. Every kernel returns
+the same result.
+--------------------------------------------------------------------------*/
+
+bool vectorKernelUsesAvx2();
+/*--------------------------------------------------------------------------
+Check which instructions the vector kernel runs.
+
+Precondition:  None.
+Postcondition: Returns true if AuditKernel::Vector uses AVX2 on this
+processor, false if it runs the portable loop.
+--------------------------------------------------------------------------*/
+
+/******** Results ********/
+struct AuditMismatch {
+    int accountNumber = 0;  // Account whose balance disagrees
+    bool rolledUp = false;  // False: own balance; true: balance including subaccounts
+    Money recomputed;       // Value computed from the transactions
+    Money maintained;       // Value the tree holds
+};
+
+struct AuditReport {
+    size_t accounts = 0;                // Accounts checked
+    size_t transactions = 0;            // Transactions summed
+    vector<AuditMismatch> mismatches;   // Disagreeing balances, in preorder
+
+    bool passed() const { return mismatches.empty(); }
+};
@@ -0,0 +1,157 @@
+#include "BalanceHistory.h"
+#include <algorithm>
+
+BalanceHistory::BalanceHistory()
+ : totalCents(0) {}
+
+int BalanceHistory::dayNumber(int date) {
+    // Days from civil date (proleptic Gregorian), counting March-based years
+    int year = date / 10000, month = date / 100 % 100, day = date % 100;
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+int64_t BalanceHistory::prefixCents(size_t buckets) const {
+    int64_t sum = 0;
+    for (size_t i = buckets; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+vector<int64_t> BalanceHistory::bucketCents() const {
+    // Undo the linear construction, last node first
+    size_t count = days.size();
+    if (count == 0) {
+        return vector<int64_t>();
+    }
+    vector<int64_t> nodes(tree);
+    for (size_t i = count; i > 0; i--) {
+        size_t parent = i + (i & -i);
+        if (parent <= count) {
+            nodes[parent] -= nodes[i];
+        }
+    }
+    return vector<int64_t>(nodes.begin() + 1, nodes.begin() + count + 1);
+}
+
+void BalanceHistory::rebuild(vector<int> newDays, const vector<int64_t> & cents) {
+    size_t count = newDays.size();
+    tree.assign(count + 1, 0);
+    for (size_t i = 0; i < count; i++) {
+        tree[i + 1] = cents[i];
+    }
+    // Linear Fenwick construction: push each node into its parent
+    for (size_t i = 1; i <= count; i++) {
+        size_t parent = i + (i & -i);
+        if (parent <= count) {
+            tree[parent] += tree[i];
+        }
+    }
+    days.swap(newDays);
+}
+
+void BalanceHistory::merge(const vector<int> & otherDays, const vector<int64_t> & otherCents) {
+    vector<int64_t> values = bucketCents();
+    vector<int> mergedDays;
+    vector<int64_t> mergedCents;
+    mergedDays.reserve(days.size() + otherDays.size());
+    mergedCents.reserve(days.size() + otherDays.size());
+    size_t i = 0, j = 0;
+    while (i < days.size() || j < otherDays.size()) {
+        if (j == otherDays.size() || (i < days.size() && days[i] < otherDays[j])) {
+            mergedDays.push_back(days[i]);
+            mergedCents.push_back(values[i++]);
+        } else if (i == days.size() || otherDays[j] < days[i]) {
+            mergedDays.push_back(otherDays[j]);
+            mergedCents.push_back(otherCents[j++]);
+        } else {
+            mergedDays.push_back(days[i]);
+            mergedCents.push_back(values[i++] + otherCents[j++]);
+        }
+    }
+    rebuild(move(mergedDays), mergedCents);
+}
+
+void BalanceHistory::add(int date, Money amount) {
+    int day = dayNumber(date);
+    int64_t cents = amount.getCents();
+    totalCents += cents;
+    size_t pos = lower_bound(days.begin(), days.end(), day) - days.begin();
+    if (pos < days.size() && days[pos] == day) {
+        for (size_t i = pos + 1; i < tree.size(); i += i & -i) {
+            tree[i] += cents;
+        }
+    } else if (pos == days.size()) {
+        // A new last bucket: its node covers (i - lowbit(i), i]
+        if (tree.empty()) {
+            tree.push_back(0);
+        }
+        size_t i = days.size() + 1;
+        days.push_back(day);
+        tree.push_back(cents + prefixCents(i - 1) - prefixCents(i - (i & -i)));
+    } else {
+        merge(vector<int>{day}, vector<int64_t>{cents});
+    }
+}
+
+void BalanceHistory::addAll(vector<pair<int, Money>> & dated) {
+    sort(dated.begin(), dated.end(), [](const pair<int, Money> & a, const pair<int, Money> & b) {
+        return a.first < b.first;
+    });
+    vector<int> newDays;
+    vector<int64_t> newCents;
+    for (size_t i = 0; i < dated.size(); i++) {
+        int64_t cents = dated[i].second.getCents();
+        totalCents += cents;
+        if (i > 0 && dated[i].first == dated[i - 1].first) {
+            newCents.back() += cents;
+        } else {
+            newDays.push_back(dayNumber(dated[i].first));
+            newCents.push_back(cents);
+        }
+    }
+    if (!newDays.empty()) {
+        merge(newDays, newCents);
+    }
+}
+
+void BalanceHistory::addHistory(const BalanceHistory & other) {
+    if (other.days.empty()) {
+        return;
+    }
+    merge(other.days, other.bucketCents());
+    totalCents += other.totalCents;
+}
+
+void BalanceHistory::clear() {
+    days.clear();
+    tree.clear();
+    totalCents = 0;
+}
+
+Money BalanceHistory::totalThrough(int date) const {
+    int day = dayNumber(date);
+    return Money::fromCents(prefixCents(upper_bound(days.begin(), days.end(), day) - days.begin()));
+}
+
+Money BalanceHistory::totalBetween(int fromDate, int toDate) const {
+    if (fromDate > toDate) {
+        return Money();
+    }
+    int fromDay = dayNumber(fromDate);
+    int64_t before = prefixCents(lower_bound(days.begin(), days.end(), fromDay) - days.begin());
+    return totalThrough(toDate) - Money::fromCents(before);
+}
+
+Money BalanceHistory::total() const {
+    return Money::fromCents(totalCents);
+}
+
+size_t BalanceHistory::bucketCount() const {
+    return days.size();
+}
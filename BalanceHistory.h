@@ -0,0 +1,163 @@
+/*-- BalanceHistory.h --------------------------------------------------------
+
+  This header file defines the BalanceHistory class, a cumulative index of
+  an account's dated postings over day buckets.
+
+  Net amounts are kept per calendar day in a Fenwick (binary indexed)
+  tree, so adding a posting and asking for the total posted up to a date
+  both take O(log d) for d buckets. Buckets are sparse: only days that
+  have postings get one, kept in ascending day order, so memory depends on
+  the number of distinct days and not on how far apart they are. A new
+  day after every other is appended in O(log d); one between existing
+  days rebuilds the tree in O(d). Whole histories and batches of postings
+  are merged in a single linear rebuild.
+
+  Basic operations include:
+     - Recording: Add a signed amount on a date, a batch of them, or
+       another history
+     - Queries: Total through a date, total between two dates, grand total
+     - Dates: Conversion of yyyymmdd dates to day numbers
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Money.h"
+
+using namespace std;
+
+class BalanceHistory {
+private:
+    /******** Data Members ********/
+    vector<int> days;          // Day number of each bucket, ascending
+    vector<int64_t> tree;      // Fenwick tree of net cents per bucket; tree[0] unused
+    int64_t totalCents;        // Net cents of every bucket
+
+    /******** Private Member Functions ********/
+    int64_t prefixCents(size_t buckets) const;
+    /*----------------------------------------------------------------------
+    Sum the first buckets.
+
+    Precondition:  buckets <= bucketCount().
+    Postcondition: Returns the net cents of buckets [0, buckets).
+    -----------------------------------------------------------------------*/
+
+    vector<int64_t> bucketCents() const;
+    /*----------------------------------------------------------------------
+    Recover the net cents of each bucket.
+
+    Precondition:  None.
+    Postcondition: Returns one value per bucket, in day order, in O(d).
+    -----------------------------------------------------------------------*/
+
+    void rebuild(vector<int> newDays, const vector<int64_t> &cents);
+    /*----------------------------------------------------------------------
+    Replace the buckets.
+
+    Precondition:  newDays is ascending without repeats and cents has one
+    value per day.
+    Postcondition: The buckets are newDays holding cents; the tree is
+    built in linear time. totalCents is not changed.
+    -----------------------------------------------------------------------*/
+
+    void merge(const vector<int> &otherDays, const vector<int64_t> &otherCents);
+    /*----------------------------------------------------------------------
+    Add per-day amounts to the buckets.
+
+    Precondition:  otherDays is ascending without repeats and otherCents
+    has one value per day.
+    Postcondition: Each amount is added to its day's bucket, creating the
+    buckets that are missing, in O(d + n) for n days merged.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    BalanceHistory();
+    /*----------------------------------------------------------------------
+    Construct an empty history.
+
+    Precondition:  None.
+    Postcondition: No days are covered and every total is 0.
+    -----------------------------------------------------------------------*/
+
+    /******** Dates ********/
+    static int dayNumber(int date);
+    /*----------------------------------------------------------------------
+    Convert a date to a day number.
+
+    Precondition:  Transaction::isValidDate(date).
+    Postcondition: Returns the number of days from 1970-01-01 to date
+    (negative before it); consecutive dates get consecutive numbers.
+    -----------------------------------------------------------------------*/
+
+    /******** Recording ********/
+    void add(int date, Money amount);
+    /*----------------------------------------------------------------------
+    Record a signed amount on a date.
+
+    Precondition:  Transaction::isValidDate(date).
+    Postcondition: Every total that includes date changes by amount.
+    -----------------------------------------------------------------------*/
+
+    void addAll(vector<pair<int, Money>> &dated);
+    /*----------------------------------------------------------------------
+    Record several signed amounts, each on its date.
+
+    Precondition:  Every date in dated is valid.
+    Postcondition: As add for each entry, with one rebuild; dated is left
+    in an unspecified order. Runs in O(n log n + d).
+    -----------------------------------------------------------------------*/
+
+    void addHistory(const BalanceHistory &other);
+    /*----------------------------------------------------------------------
+    Record everything another history holds.
+
+    Precondition:  other is not this history.
+    Postcondition: Every total includes other's total over the same
+    dates. Runs in O(d + d') for d' buckets of other.
+    -----------------------------------------------------------------------*/
+
+    void clear();
+    /*----------------------------------------------------------------------
+    Forget everything recorded.
+
+    Precondition:  None.
+    Postcondition: The history is empty.
+    -----------------------------------------------------------------------*/
+
+    /******** Queries ********/
+    Money totalThrough(int date) const;
+    /*----------------------------------------------------------------------
+    Get the net amount recorded on or before a date.
+
+    Precondition:  Transaction::isValidDate(date).
+    Postcondition: Returns the total in O(log d).
+    -----------------------------------------------------------------------*/
+
+    Money totalBetween(int fromDate, int toDate) const;
+    /*----------------------------------------------------------------------
+    Get the net amount recorded between two dates, both included.
+
+    Precondition:  Both dates are valid.
+    Postcondition: Returns the total in O(log d); 0 if fromDate > toDate.
+    -----------------------------------------------------------------------*/
+
+    Money total() const;
+    /*----------------------------------------------------------------------
+    Get the net amount of everything recorded.
+
+    Precondition:  None.
+    Postcondition: Returns the total in O(1).
+    -----------------------------------------------------------------------*/
+
+    size_t bucketCount() const;
+    /*----------------------------------------------------------------------
+    Get the number of days covered.
+
+    Precondition:  None.
+    Postcondition: Returns the number of distinct days with a bucket.
+    -----------------------------------------------------------------------*/
+};
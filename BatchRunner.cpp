@@ -0,0 +1,336 @@
+#include "BatchRunner.h"
+#include "OutputBuffer.h"
+#include <chrono>
+#include <charconv>
+#include <iterator>
+
+// Stream buffer that hands everything to an OutputBuffer. sync() does not
+// flush, so endl in command output does not cost a write per line.
+class BlockStreamBuf : public streambuf {
+private:
+    OutputBuffer &block;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            block.put(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+    streamsize xsputn(const char *s, streamsize n) override {
+        block.write(string_view(s, n));
+        return n;
+    }
+
+public:
+    explicit BlockStreamBuf(OutputBuffer &block) : block(block) {}
+};
+
+// Prints the core classes' diagnostics as error messages. The command
+// output collected so far is written first (cerr is tied to cout), so the
+// two appear in the order the commands produced them.
+class BatchDiagnostics : public DiagnosticSink {
+private:
+    OutputBuffer &block;
+
+public:
+    explicit BatchDiagnostics(OutputBuffer &block) : block(block) {}
+
+    void report(Status, const string &message) override {
+        block.flush();
+        cerr << message << '\n';
+    }
+};
+
+// Splits off the next space-separated token of a command line
+static string_view nextToken(string_view & rest) {
+    size_t start = rest.find_first_not_of(' ');
+    if (start == string_view::npos) {
+        rest = string_view();
+        return string_view();
+    }
+    rest.remove_prefix(start);
+    size_t end = rest.find(' ');
+    string_view token = rest.substr(0, end);
+    rest.remove_prefix(end == string_view::npos ? rest.size() : end);
+    return token;
+}
+
+static bool parseInt(string_view token, int & value) {
+    const char * end = token.data() + token.size();
+    return !token.empty() && from_chars(token.data(), end, value).ptr == end;
+}
+
+BatchRunner::BatchRunner(ForestTree & tree, BatchOutput output)
+ : tree(tree), output(output), commandOut(nullptr) {}
+
+BatchRunner::~BatchRunner() {
+    if (journal.isOpen() || journal.hasFailed()) {
+        tree.setJournal(nullptr);
+    }
+}
+
+void BatchRunner::run(string_view commands) {
+    auto start = chrono::steady_clock::now();
+
+    // Command output goes to cout in large blocks; quiet runs have none
+    OutputBuffer block(cout);
+    BlockStreamBuf blockBuf(block);
+    ostream blockOut(&blockBuf);
+    commandOut = output == BatchOutput::Buffered ? &blockOut : nullptr;
+
+    BatchDiagnostics diagnostics(block);
+    DiagnosticSink * savedSink = getDiagnosticSink();
+    setDiagnosticSink(output == BatchOutput::Buffered ? &diagnostics : nullptr);
+
+    while (!commands.empty()) {
+        size_t lineEnd = commands.find('\n');
+        string_view line = commands.substr(0, lineEnd);
+        commands.remove_prefix(lineEnd == string_view::npos ? commands.size() : lineEnd + 1);
+        while (!line.empty() && isspace((unsigned char)line.back())) {
+            line.remove_suffix(1);
+        }
+        size_t first = line.find_first_not_of(" \t");
+        if (first == string_view::npos || line[first] == '#') {
+            continue;
+        }
+        if (!execute(line.substr(first))) {
+            summary.invalidLines++;
+            diagnose(Status::InvalidFormat, [&] { return "Error: invalid command: " + string(line); });
+        }
+    }
+    flushPostings();
+
+    block.flush();
+    commandOut = nullptr;
+    setDiagnosticSink(savedSink);
+    summary.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+bool BatchRunner::runFile(const string & filePath) {
+    if (filePath == "-") {
+        string commands((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+        run(commands);
+        return true;
+    }
+    MappedFile file;
+    if (!file.open(filePath)) {
+        return false;
+    }
+    run(string_view(file.data(), file.size()));
+    return true;
+}
+
+bool BatchRunner::execute(string_view line) {
+    string_view rest = line;
+    string_view command = nextToken(rest);
+
+    // Postings are queued; everything else sees them applied first
+    if (command == "post") {
+        int account, id, date = 0;
+        Money amount;
+        string_view amountText, type, dateText;
+        if (!parseInt(nextToken(rest), account) || !parseInt(nextToken(rest), id) || id < 1 ||
+            (amountText = nextToken(rest)).empty() ||
+            !Money::parse(amountText.data(), amountText.data() + amountText.size(), amount) ||
+            amount < Money() || (type = nextToken(rest)).size() != 1) {
+            return false;
+        }
+        if (!(dateText = nextToken(rest)).empty() &&
+            (!parseInt(dateText, date) || !Transaction::isValidDate(date) || !nextToken(rest).empty())) {
+            return false;
+        }
+        Transaction t(id, amount, 'D', date);
+        if (!t.setType(type[0])) {
+            return false;
+        }
+        postings.push_back({account, t});
+        summary.commands++;
+        if (postings.size() >= POST_BATCH_SIZE) {
+            flushPostings();
+        }
+        return true;
+    }
+    flushPostings();
+
+    bool succeeded = true;
+    if (command == "delete") {
+        // "delete ID" finds the account through the transaction index
+        int first, id;
+        string_view idText;
+        if (!parseInt(nextToken(rest), first) || (!(idText = nextToken(rest)).empty() && !parseInt(idText, id)) ||
+            !nextToken(rest).empty()) {
+            return false;
+        }
+        Status status = idText.empty() ? tree.removeTransaction(first) : tree.removeAccountTransaction(first, id);
+        if (status == Status::Ok) {
+            summary.deleted++;
+        } else {
+            summary.failed++;
+        }
+        summary.commands++;
+        return true;
+    } else if (command == "account") {
+        int number;
+        Money balance;
+        string_view balanceText;
+        if (!parseInt(nextToken(rest), number) || (balanceText = nextToken(rest)).empty() ||
+            !Money::parse(balanceText.data(), balanceText.data() + balanceText.size(), balance)) {
+            return false;
+        }
+        size_t start = rest.find_first_not_of(' ');
+        if (start == string_view::npos) {
+            return false;
+        }
+        succeeded = tree.addAccount(number, string(rest.substr(start)), balance) == Status::Ok;
+    } else if (command == "find" || command == "report") {
+        int number;
+        if (!parseInt(nextToken(rest), number) || !nextToken(rest).empty()) {
+            return false;
+        }
+        if (command == "report") {
+            succeeded = tree.printAccount(number) == Status::Ok;
+        } else if (commandOut != nullptr) {
+            succeeded = tree.findAccount(number, *commandOut) == Status::Ok;
+        } else {
+            Money balance;
+            succeeded = tree.getAccountBalance(number, balance);
+        }
+    } else if (command == "asof") {
+        int number, date;
+        if (!parseInt(nextToken(rest), number) || !parseInt(nextToken(rest), date) || !nextToken(rest).empty()) {
+            return false;
+        }
+        Money balance;
+        succeeded = tree.getBalanceAsOf(number, date, balance) == Status::Ok;
+        if (succeeded && commandOut != nullptr) {
+            *commandOut << "Balance of " << number << " as of " << date << ": " << balance << '\n';
+        }
+    } else if (command == "locate") {
+        int id;
+        if (!parseInt(nextToken(rest), id) || !nextToken(rest).empty()) {
+            return false;
+        }
+        int account;
+        Transaction found;
+        succeeded = tree.findTransaction(id, account, found) == Status::Ok;
+        if (succeeded && commandOut != nullptr) {
+            *commandOut << "Found in account " << account << ":\n" << found << '\n';
+        }
+    } else if (command == "audit") {
+        if (!nextToken(rest).empty()) {
+            return false;
+        }
+        AuditReport report = tree.auditBalances();
+        succeeded = report.passed();
+        if (commandOut != nullptr) {
+            *commandOut << "Audit: " << report.accounts << " accounts, " << report.transactions
+                        << " transactions, " << report.mismatches.size() << " mismatches\n";
+            for (const AuditMismatch & m : report.mismatches) {
+                *commandOut << "  " << m.accountNumber << (m.rolledUp ? " balance: " : " own balance: ")
+                            << "recomputed " << m.recomputed << ", held " << m.maintained << '\n';
+            }
+        }
+    } else if (command == "export") {
+        string_view token = nextToken(rest);
+        if (token == "all" && nextToken(rest).empty()) {
+            succeeded = tree.exportAllAccountReports() == Status::Ok;
+        } else {
+            vector<int> numbers;
+            for (; !token.empty(); token = nextToken(rest)) {
+                int number;
+                if (!parseInt(token, number)) {
+                    return false;
+                }
+                numbers.push_back(number);
+            }
+            if (numbers.empty()) {
+                return false;
+            }
+            // Like report, a missing account or an unwritten file fails the command
+            sort(numbers.begin(), numbers.end());
+            numbers.erase(unique(numbers.begin(), numbers.end()), numbers.end());
+            succeeded = tree.exportAccountReports(numbers) == numbers.size();
+        }
+    } else {
+        // The remaining commands take a single file argument
+        string path(nextToken(rest));
+        if (path.empty() || !nextToken(rest).empty()) {
+            return false;
+        }
+        if (command == "load") {
+            succeeded = tree.buildTreeFromFile(path);
+        } else if (command == "tree") {
+            succeeded = tree.printTreeIntoFile(path);
+        } else if (command == "full") {
+            string folderName = "Extra_features/";
+            if (!filesystem::exists(folderName)) {
+                filesystem::create_directory(folderName);
+            }
+            ofstream outFile(folderName + path + (path.find(".txt") != string::npos ? "" : ".txt"));
+            outFile << tree;
+            succeeded = outFile.good();
+        } else if (command == "save") {
+            succeeded = tree.saveSnapshot(path);
+        } else if (command == "restore") {
+            succeeded = tree.loadSnapshot(path) == Status::Ok;
+        } else if (command == "journal") {
+            tree.setJournal(nullptr);
+            succeeded = journal.open(path);
+            if (succeeded) {
+                tree.setJournal(&journal);
+            }
+        } else if (command == "replay") {
+            succeeded = tree.replayJournal(path);
+        } else if (command == "checkpoint") {
+            succeeded = tree.checkpoint(path);
+        } else {
+            return false;
+        }
+    }
+    if (!succeeded) {
+        summary.failed++;
+    }
+    summary.commands++;
+    return true;
+}
+
+void BatchRunner::flushPostings() {
+    if (postings.empty()) {
+        return;
+    }
+    vector<PostStatus> results = tree.postBatch(postings);
+    for (PostStatus status : results) {
+        switch (status) {
+            case PostStatus::Posted:
+                summary.posted++;
+                break;
+            case PostStatus::AccountNotFound:
+                summary.missingAccounts++;
+                break;
+            case PostStatus::DuplicateTransaction:
+                summary.duplicates++;
+                break;
+            case PostStatus::JournalError:
+                summary.failed++;
+                break;
+        }
+    }
+    postings.clear();
+}
+
+const BatchSummary & BatchRunner::getSummary() const {
+    return summary;
+}
+
+void BatchRunner::printSummary(ostream & out) const {
+    out << "*** Batch Summary ***\n"
+        << "Commands executed: " << summary.commands << '\n'
+        << "Invalid lines: " << summary.invalidLines << '\n'
+        << "Transactions posted: " << summary.posted << '\n'
+        << "Duplicate transactions: " << summary.duplicates << '\n'
+        << "Postings to missing accounts: " << summary.missingAccounts << '\n'
+        << "Transactions deleted: " << summary.deleted << '\n'
+        << "Failed commands: " << summary.failed << '\n'
+        << "Elapsed time: " << summary.seconds << " s\n";
+}
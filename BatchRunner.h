@@ -0,0 +1,150 @@
+/*-- BatchRunner.h -----------------------------------------------------------
+
+  This header file defines the BatchRunner class, which executes a command
+  file against a ForestTree without the interactive menu.
+
+  A command file holds one command per line; blank lines and lines
+  starting with '#' are skipped:
+
+     load FILE                          Build the chart from a text file
+     account NUMBER BALANCE DESCRIPTION Add an account
+     post ACCOUNT ID AMOUNT D|C [DATE]  Add a transaction, dated yyyymmdd
+     delete [ACCOUNT] ID                Remove a transaction, by ID alone if no ACCOUNT
+     locate ID                          Print a transaction and its account
+     find ACCOUNT                       Print an account
+     asof ACCOUNT DATE                  Print an account's balance on a date
+     audit                              Recompute and check every balance
+     report ACCOUNT                     Print an account's report file
+     export all | ACCOUNT...            Print many report files at once
+     tree FILE                          Print the chart into a file
+     full FILE                          Print the chart with transactions
+     save PATH / restore PATH           Save or load a binary snapshot
+     journal PATH                       Journal postings from now on
+     replay PATH                        Replay a journal
+     checkpoint PATH                    Save a snapshot and reset the journal
+
+  Consecutive post commands are applied together through postBatch.
+  Console output of the commands is collected in large blocks, or dropped
+  entirely, and a summary is printed at the end.
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+#include "ForestTree.h"
+
+using namespace std;
+
+/******** Output Handling ********/
+enum class BatchOutput {
+    Buffered,   // Command output is written in large blocks
+    Quiet       // No command output or error messages are produced
+};
+
+/******** Run Summary ********/
+struct BatchSummary {
+    size_t commands = 0;          // Commands executed
+    size_t invalidLines = 0;      // Lines that were not valid commands
+    size_t posted = 0;            // Transactions added
+    size_t duplicates = 0;        // Postings rejected as duplicate IDs
+    size_t missingAccounts = 0;   // Postings for accounts that do not exist
+    size_t deleted = 0;           // Transactions removed
+    size_t failed = 0;            // Other commands, and unjournaled postings, that did not succeed
+    double seconds = 0;           // Wall time of the run
+};
+
+class BatchRunner {
+private:
+    /******** Data Members ********/
+    static const size_t POST_BATCH_SIZE = 1 << 16;   // Postings applied per postBatch call
+
+    ForestTree &tree;                        // Tree the commands run against
+    BatchOutput output;                      // Output handling
+    BatchSummary summary;                    // Counts of the current run
+    vector<pair<int, Transaction>> postings; // Post commands not yet applied
+    Journal journal;                         // Opened by the journal command
+    ostream *commandOut;                     // Output of find while running, or nullptr
+
+    /******** Private Member Functions ********/
+    bool execute(string_view line);
+    /*----------------------------------------------------------------------
+    Execute one command line.
+
+    Precondition:  line is not blank and not a comment.
+    Postcondition: The command is executed or queued and counted. Returns
+    false if the line is not a valid command.
+    -----------------------------------------------------------------------*/
+
+    void flushPostings();
+    /*----------------------------------------------------------------------
+    Apply the queued postings.
+
+    Precondition:  None.
+    Postcondition: Every queued posting went through postBatch and is
+    counted; the queue is empty.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    BatchRunner(ForestTree &tree, BatchOutput output = BatchOutput::Buffered);
+    /*----------------------------------------------------------------------
+    Construct a runner for a tree.
+
+    Precondition:  tree outlives the runner.
+    Postcondition: The runner is ready; the summary is empty.
+    -----------------------------------------------------------------------*/
+
+    ~BatchRunner();
+    /*----------------------------------------------------------------------
+    Detach the runner's journal from the tree.
+
+    Precondition:  None.
+    Postcondition: The tree no longer journals through this runner.
+    -----------------------------------------------------------------------*/
+
+    BatchRunner(const BatchRunner &) = delete;
+    BatchRunner &operator=(const BatchRunner &) = delete;
+
+    /******** Running ********/
+    void run(string_view commands);
+    /*----------------------------------------------------------------------
+    Execute a block of command lines.
+
+    Precondition:  None.
+    Postcondition: Every line was executed in order and is counted in the
+    summary. In buffered mode command output is written to cout in large
+    blocks and diagnostics go to cerr, each after the output before it; in
+    quiet mode neither is written.
+    The previously installed DiagnosticSink is restored afterwards.
+    -----------------------------------------------------------------------*/
+
+    bool runFile(const string &filePath);
+    /*----------------------------------------------------------------------
+    Execute a command file, or standard input if filePath is "-".
+
+    Precondition:  None.
+    Postcondition: As run() for the whole contents. Returns false if the
+    file could not be read.
+    -----------------------------------------------------------------------*/
+
+    /******** Summary ********/
+    const BatchSummary &getSummary() const;
+    /*----------------------------------------------------------------------
+    Get the counts of everything run so far.
+
+    Precondition:  None.
+    Postcondition: Returns the summary.
+    -----------------------------------------------------------------------*/
+
+    void printSummary(ostream &out) const;
+    /*----------------------------------------------------------------------
+    Print the summary.
+
+    Precondition:  out is open.
+    Postcondition: One line per count is written to out.
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,150 @@
+#include "ForestSnapshot.h"
+#include "ForestTree.h"
+
+ForestSnapshot::ForestSnapshot() {
+    descriptionOffsets.push_back(0);
+    transactionOffsets.push_back(0);
+}
+
+ForestSnapshot::ForestSnapshot(const ForestTree & tree) : ForestSnapshot() {
+    tree.settleAllBalances();
+    size_t count = tree.nodes.size();
+    numbers.reserve(count);
+    balances.reserve(count);
+    depths.reserve(count);
+    subtreeEnds.reserve(count);
+    descriptionOffsets.reserve(count + 1);
+    transactionOffsets.reserve(count + 1);
+    positions.reserve(count);
+
+    // Preorder walk: a node, then its child list, then its next sibling
+    vector<pair<ForestTree::nodePtr, int>> pending;
+    vector<uint32_t> open;   // Positions whose subtree end is not known yet
+    if (tree.root != nullptr) {
+        pending.push_back({tree.root, 0});
+    }
+    while (!pending.empty()) {
+        ForestTree::nodePtr node = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+
+        uint32_t pos = numbers.size();
+        while (!open.empty() && depths[open.back()] >= depth) {
+            subtreeEnds[open.back()] = pos;
+            open.pop_back();
+        }
+        open.push_back(pos);
+
+        const Account & acc = node->data;
+        numbers.push_back(acc.getAccountNumber());
+        balances.push_back(acc.getBalance());
+        depths.push_back(depth);
+        subtreeEnds.push_back(0);
+        positions[acc.getAccountNumber()] = pos;
+
+        const string & description = acc.getDescription();
+        descriptionPool += description;
+        descriptionOffsets.push_back(descriptionPool.size());
+
+        // The columns are copied straight from the account's store; the
+        // credit bits are shifted to the account's place in the pool
+        const TransactionStore & transactions = acc.getTransactions();
+        const vector<int> & ids = transactions.getIds();
+        const vector<int> & dates = transactions.getDates();
+        const vector<int64_t> & cents = transactions.getAmountCents();
+        size_t first = transactionIds.size();
+        transactionIds.insert(transactionIds.end(), ids.begin(), ids.end());
+        transactionDates.insert(transactionDates.end(), dates.begin(), dates.end());
+        amountCents.insert(amountCents.end(), cents.begin(), cents.end());
+        creditBits.resize((transactionIds.size() + 63) / 64);
+        for (size_t t = 0; t < ids.size(); t++) {
+            if (transactions.isCredit(t)) {
+                creditBits[(first + t) / 64] |= (uint64_t)1 << ((first + t) % 64);
+            }
+        }
+        transactionOffsets.push_back(transactionIds.size());
+
+        if (node->sibling != nullptr) {
+            pending.push_back({node->sibling, depth});
+        }
+        if (node->child != nullptr) {
+            pending.push_back({node->child, depth + 1});
+        }
+    }
+    for (uint32_t pos : open) {
+        subtreeEnds[pos] = numbers.size();
+    }
+}
+
+// Access
+size_t ForestSnapshot::size() const {
+    return numbers.size();
+}
+
+int ForestSnapshot::getAccountNumber(size_t pos) const {
+    return numbers[pos];
+}
+
+Money ForestSnapshot::getBalance(size_t pos) const {
+    return balances[pos];
+}
+
+int ForestSnapshot::getDepth(size_t pos) const {
+    return depths[pos];
+}
+
+size_t ForestSnapshot::getSubtreeEnd(size_t pos) const {
+    return subtreeEnds[pos];
+}
+
+string_view ForestSnapshot::getDescription(size_t pos) const {
+    return string_view(descriptionPool.data() + descriptionOffsets[pos],
+                       descriptionOffsets[pos + 1] - descriptionOffsets[pos]);
+}
+
+size_t ForestSnapshot::transactionsBegin(size_t pos) const {
+    return transactionOffsets[pos];
+}
+
+size_t ForestSnapshot::transactionsEnd(size_t pos) const {
+    return transactionOffsets[pos + 1];
+}
+
+Transaction ForestSnapshot::getTransaction(size_t index) const {
+    bool credit = (creditBits[index / 64] >> (index % 64)) & 1;
+    return Transaction(transactionIds[index], Money::fromCents(amountCents[index]), credit ? 'C' : 'D',
+                       transactionDates[index]);
+}
+
+// Range queries
+bool ForestSnapshot::find(int accountNumber, size_t & pos) const {
+    auto it = positions.find(accountNumber);
+    if (it == positions.end()) {
+        return false;
+    }
+    pos = it->second;
+    return true;
+}
+
+bool ForestSnapshot::subtreeRange(int accountNumber, size_t & begin, size_t & end) const {
+    if (!find(accountNumber, begin)) {
+        return false;
+    }
+    end = subtreeEnds[begin];
+    return true;
+}
+
+// Printing
+void ForestSnapshot::print(ostream & out) const {
+    if (numbers.empty()) {
+        out << "tree empty";
+        return;
+    }
+    OutputBuffer buffer(out);
+    for (size_t pos = 0; pos < numbers.size(); pos++) {
+        size_t first = transactionsBegin(pos);
+        ForestTree::writeAccountBlock(buffer, depths[pos], numbers[pos], getDescription(pos), balances[pos],
+                                      transactionsEnd(pos) - first,
+                                      [&](size_t i) { return getTransaction(first + i); });
+    }
+}
@@ -0,0 +1,147 @@
+/*-- ForestSnapshot.h --------------------------------------------------------
+
+  This header file defines the ForestSnapshot class, a compact read-only
+  copy of a ForestTree laid out for fast sequential reads.
+
+  Accounts are stored in preorder (an account, then its subaccounts, then
+  its next sibling) in parallel arrays: account number, balance, depth and
+  the position just past the account's subtree. Descriptions and
+  transactions live in two shared pools addressed by offsets. A whole-tree
+  traversal is a linear scan, and every subtree is a contiguous range
+  [i, getSubtreeEnd(i)). The transaction pool is columnar in the layout a
+  TransactionStore uses: IDs, dates, non-negative amounts in cents and one
+  bit per transaction that is set for credits.
+
+  Basic operations include:
+     - Construction: One pass over a ForestTree, through ForestTree::snapshot
+     - Access: Per-position account data and transaction ranges
+     - Range queries: Position and subtree range of an account
+     - Printing: The same report as operator<< on the ForestTree
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <iostream>
+#include "Transaction.h"
+#include "Money.h"
+
+using namespace std;
+
+class ForestTree;
+
+class ForestSnapshot {
+private:
+    /******** Account Columns (preorder) ********/
+    vector<int> numbers;                  // Account numbers
+    vector<Money> balances;               // Rolled-up balances
+    vector<uint16_t> depths;              // Depth below the root level
+    vector<uint32_t> subtreeEnds;         // One past the last position of each subtree
+
+    /******** Pools ********/
+    string descriptionPool;               // All descriptions, back to back
+    vector<uint32_t> descriptionOffsets;  // Start of each description (size()+1 entries)
+    vector<int> transactionIds;           // All transaction IDs, grouped per account in ID order
+    vector<int> transactionDates;         // Their dates, in the same order
+    vector<uint32_t> transactionOffsets;  // Start of each account's transactions (size()+1 entries)
+    vector<int64_t> amountCents;          // Their non-negative amounts
+    vector<uint64_t> creditBits;          // Bit i set if pool transaction i is a credit
+
+    unordered_map<int, uint32_t> positions; // Account number -> position
+
+    /******** Private Constructors ********/
+    explicit ForestSnapshot(const ForestTree &tree);
+    /*----------------------------------------------------------------------
+    Copy a tree into the flattened layout; used by ForestTree::snapshot,
+    which holds the tree exclusively meanwhile.
+
+    Precondition:  The tree is held exclusively and holds fewer than 2^32
+    accounts, description bytes and transactions.
+    Postcondition: The snapshot holds every account of the tree in preorder
+    with settled rolled-up balances. Later changes to the tree are not
+    reflected.
+    -----------------------------------------------------------------------*/
+
+    friend class ForestTree;
+
+public:
+    /******** Constructors ********/
+    ForestSnapshot();
+    /*----------------------------------------------------------------------
+    Construct an empty snapshot.
+
+    Precondition:  None.
+    Postcondition: size() returns 0. Snapshots of a tree are built with
+    ForestTree::snapshot.
+    -----------------------------------------------------------------------*/
+
+    /******** Access ********/
+    size_t size() const;
+    /*----------------------------------------------------------------------
+    Get the number of accounts.
+
+    Precondition:  None.
+    Postcondition: Returns the number of accounts in the snapshot.
+    -----------------------------------------------------------------------*/
+
+    int getAccountNumber(size_t pos) const;
+    Money getBalance(size_t pos) const;
+    int getDepth(size_t pos) const;
+    size_t getSubtreeEnd(size_t pos) const;
+    string_view getDescription(size_t pos) const;
+    /*----------------------------------------------------------------------
+    Get the data of the account at a preorder position.
+
+    Precondition:  pos < size().
+    Postcondition: Returns the requested field.
+    -----------------------------------------------------------------------*/
+
+    size_t transactionsBegin(size_t pos) const;
+    size_t transactionsEnd(size_t pos) const;
+    /*----------------------------------------------------------------------
+    Get the transactions of the account at a preorder position.
+
+    Precondition:  pos < size().
+    Postcondition: Returns the bounds of the account's transactions in the
+    pool, in ascending ID order.
+    -----------------------------------------------------------------------*/
+
+    Transaction getTransaction(size_t index) const;
+    /*----------------------------------------------------------------------
+    Get a transaction of the pool.
+
+    Precondition:  index is below transactionsEnd(size() - 1).
+    Postcondition: Returns the transaction rebuilt from the columns.
+    -----------------------------------------------------------------------*/
+
+    /******** Range Queries ********/
+    bool find(int accountNumber, size_t &pos) const;
+    /*----------------------------------------------------------------------
+    Find the preorder position of an account.
+
+    Precondition:  None.
+    Postcondition: Returns true and sets pos if the account exists.
+    -----------------------------------------------------------------------*/
+
+    bool subtreeRange(int accountNumber, size_t &begin, size_t &end) const;
+    /*----------------------------------------------------------------------
+    Find the positions covered by an account and its subaccounts.
+
+    Precondition:  None.
+    Postcondition: Returns true and sets [begin, end) if the account exists.
+    -----------------------------------------------------------------------*/
+
+    /******** Printing ********/
+    void print(ostream &out) const;
+    /*----------------------------------------------------------------------
+    Write the full report of every account and its transactions.
+
+    Precondition:  The ostream 'out' is open.
+    Postcondition: Writes the same text as operator<< on the source tree.
+    -----------------------------------------------------------------------*/
+};
@@ -1,84 +1,142 @@
 #include "ForestTree.h"
 
-ForestTree::ForestTree() : root(nullptr) {}
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define SNAPSHOT_USE_FSYNC 1
+#endif
 
-bool ForestTree::addAccount(const Account & acc) {
+ForestTree::ForestTree()
+ : root(nullptr), lazyBalances(false), concurrent(false), journal(nullptr), reportThreads(1) {}
+
+void ForestTree::clear() {
+    unique_lock<shared_mutex> tree = lockTree();
+    resetTree();
+}
+
+void ForestTree::resetTree() {
+    root = nullptr;
+    nodes.clear();
+    rollupCounters.clear();
+    directIndex.clear();
+    overflowIndex.clear();
+    for (TransactionIndex & part : transactionIndex) {
+        part.clear();
+    }
+}
+
+Status ForestTree::addAccount(const Account & acc) {
+    unique_lock<shared_mutex> tree = lockTree();
+    Status status = insertAccount(acc);
+    if (status == Status::Ok && concurrent) {
+        assignRollupCounters();
+    }
+    return status;
+}
+
+Status ForestTree::insertAccount(const Account & acc) {
     int accountNum = acc.getAccountNumber();
-    nodePtr newNode = new Node(acc);
+    if (accountNum < 1) {
+        diagnose(Status::InvalidAccountNumber, [] { return string("Invalid Account Number"); });
+        return Status::InvalidAccountNumber;
+    }
 
     // Check if main account exists, otherwise don't allow to create subaccounts
     if (accountNum > 9) {
-        char firstDigit = to_string(accountNum)[0];
-        vector<nodePtr> res = searchAccountWithTracking(firstDigit - '0');
-        if (res[0] == nullptr)  {
-            cerr << "Can't add subaccount for account " << firstDigit << " that doesn't exist\n";
-            return false;
+        int firstDigit = Account::leadingDigit(accountNum);
+        if (lookupAccount(firstDigit) == nullptr)  {
+            diagnose(Status::ParentMissing, [&] {
+                return "Can't add subaccount for account " + to_string(firstDigit) + " that doesn't exist";
+            });
+            return Status::ParentMissing;
         }
     }
 
+    // Account already exists
+    if (lookupAccount(accountNum) != nullptr) {
+        diagnose(Status::AccountExists, [&] {
+            return "Error: Account with number " + to_string(accountNum) + " already exists!";
+        });
+        return Status::AccountExists;
+    }
+
+    // Transactions the account already holds must not use an ID of another account
+    for (int id : acc.getTransactions().getIds()) {
+        int owner = transactionIndex[transactionStripe(id)].find(id);
+        if (owner != TransactionIndex::NO_ACCOUNT) {
+            diagnose(Status::TransactionExists, [&] {
+                return "Transaction " + to_string(id) + " already exists in account " + to_string(owner);
+            });
+            return Status::TransactionExists;
+        }
+    }
+
+    nodePtr newNode = nodes.create(acc);
+
     // First node
     if (root == nullptr) {
         root = newNode;
-        return true;
+        attachAccount(newNode);
+        return Status::Ok;
     }
 
     // Insert before root
     if (accountNum < root->data.getAccountNumber()) {
         newNode->sibling = root;
         root = newNode;
-        return true;
+        attachAccount(newNode);
+        return Status::Ok;
     }
 
-    vector<Account*> tracked;
-    vector<nodePtr> res = searchAccountWithTracking(accountNum, tracked);
-    
-    // acc.getBalance() == 0
-    if (!tracked.empty()) {
-        for(auto & account : tracked) {
-            account->updateBalance(acc.getBalance());
-        }
-    }
+    int digits = Account::countDigits(accountNum);
+    vector<nodePtr> res = searchAccountWithTracking(accountNum);
 
     if (res[0] != nullptr) {
-        // Account already exists
-        if (accountNum == res[0]->data.getAccountNumber()) {
-            cerr << "Error: Account with number " << accountNum << " already exists!" << endl;
-            delete newNode;  // Cleanup
-            return false;
-        }
         // First child (current: 10 - add: 10124)
-        if (to_string(res[0]->data.getAccountNumber()).size() < to_string(accountNum).size()) {
+        if (Account::countDigits(res[0]->data.getAccountNumber()) < digits) {
             res[0]->child = newNode;
+            newNode->parent = res[0];
         } 
         // Before child (current: 10, 1011 - add: 100)
         else if (accountNum < res[0]->data.getAccountNumber()) {
             if (res[1]->child == res[0]) {
                 newNode->sibling = res[0];
                 res[1]->child = newNode;
+                newNode->parent = res[1];
             }
             else {
                 // Insert between sbilings, but with a child (current: 1, 45, 52 - add: 4)
-                if (to_string(res[0]->data.getAccountNumber()).size() > to_string(accountNum).size()) {
+                if (Account::countDigits(res[0]->data.getAccountNumber()) > digits) {
                     newNode->sibling = res[0]->sibling;
                     newNode->child = res[0];
+                    newNode->parent = res[1]->parent;
                     res[0]->sibling = nullptr;
+                    res[0]->parent = newNode;
                     res[1]->sibling = newNode;
                 }
                 // Insert between sibling and sibling (current: 1, 5 - add: 4)
                 else {
                     newNode->sibling = res[0];
+                    newNode->parent = res[1]->parent;
                     res[1]->sibling = newNode;
                 }
             }
         }
-        return true;
+        attachAccount(newNode);
+        return Status::Ok;
     }
     // Insert infront of a sibling (current: 5 - add 632)
     res[1]->sibling = newNode;
-    return true;
+    newNode->parent = res[1]->parent;
+    attachAccount(newNode);
+    return Status::Ok;
 }
 
-bool ForestTree::addAccount(int number, string description, double balance) {
+Status ForestTree::addAccount(int number, string description, Money balance) {
+    if (number < 1) {
+        diagnose(Status::InvalidAccountNumber, [] { return string("Invalid Account Number"); });
+        return Status::InvalidAccountNumber;
+    }
     Account newAccount(number, description, balance);
     return addAccount(newAccount);
 }
@@ -117,143 +175,1589 @@ vector<ForestTree::nodePtr> ForestTree::searchAccountWithTracking(int accountNum
     return searchAccountWithTracking(accountNum, dummy);
 }
 
-void ForestTree::findAccount(int accountNum) const {
-    vector<nodePtr> res = searchAccountWithTracking(accountNum);
-    if (res[0] != nullptr && res[0]->data.getAccountNumber() == accountNum) {
-        cout << "Account Found:\n" << res[0]->data;
+ForestTree::nodePtr ForestTree::lookupAccount(int accountNum) const {
+    if (accountNum < 0) {
+        return nullptr;
+    }
+    if (accountNum < DIRECT_INDEX_LIMIT) {
+        return accountNum < (int)directIndex.size() ? directIndex[accountNum] : nullptr;
+    }
+    auto it = overflowIndex.find(accountNum);
+    return it != overflowIndex.end() ? it->second : nullptr;
+}
+
+void ForestTree::indexAccount(nodePtr node) {
+    int accountNum = node->data.getAccountNumber();
+    if (accountNum < DIRECT_INDEX_LIMIT) {
+        if (accountNum >= (int)directIndex.size()) {
+            directIndex.resize(accountNum + 1, nullptr);
+        }
+        directIndex[accountNum] = node;
     } else {
-        cerr << "Error: account with number: " << accountNum << " not found!!\n";
+        overflowIndex[accountNum] = node;
     }
 }
 
-void ForestTree::addAcountTransaction(const int accountNum, const Transaction & t) {
-    vector<Account*> tracked;
-    nodePtr currNode = searchAccountWithTracking(accountNum, tracked)[0];
-    if (currNode == nullptr || currNode->data.getAccountNumber() != accountNum) {
-        cerr << "Account not found!!\n";
+void ForestTree::attachAccount(nodePtr node) {
+    indexAccount(node);
+    int accountNum = node->data.getAccountNumber();
+    // insertAccount has checked that no other account holds these IDs
+    for (int id : node->data.getTransactions().getIds()) {
+        transactionIndex[transactionStripe(id)].insert(id, accountNum);
+    }
+    node->ownBalance = node->data.getBalance();
+    rollUp(node->parent, node->ownBalance);
+    if (node->data.getHistory().bucketCount() != 0) {
+        rollUpHistory(node->parent, node->data.getHistory());
+    }
+}
+
+void ForestTree::rollUp(nodePtr ancestor, Money amount) {
+    if (concurrent) {
+        for (nodePtr p = ancestor; p != nullptr; p = p->parent) {
+            addPending(p, amount);
+        }
         return;
     }
-    currNode->data.addTransaction(t);
-    for(auto & acc : tracked) {
-        acc->updateBalance(t.getAmount() * (t.getType() == 'D' ? 1 : -1));
+    if (lazyBalances) {
+        // Ancestors above a dirty node are already dirty
+        for (nodePtr p = ancestor; p != nullptr && !p->dirty; p = p->parent) {
+            p->dirty = true;
+        }
+        return;
+    }
+    for (nodePtr p = ancestor; p != nullptr; p = p->parent) {
+        p->data.updateBalance(amount);
     }
 }
 
-void ForestTree::removeAccountTransaction(const int accountNum, const int transactionID) {
-    vector<Account*> tracked;
-    nodePtr currNode = searchAccountWithTracking(accountNum, tracked)[0];
-    if (currNode == nullptr || currNode->data.getAccountNumber() != accountNum) {
+void ForestTree::rollUpHistory(nodePtr ancestor, int date, Money amount) {
+    for (nodePtr p = ancestor; p != nullptr; p = p->parent) {
+        unique_lock<mutex> history = lockHistory(p);
+        p->data.recordHistory(date, amount);
+    }
+}
+
+void ForestTree::rollUpDated(nodePtr ancestor, int date, Money amount) {
+    if (!concurrent) {
+        rollUp(ancestor, amount);
+        rollUpHistory(ancestor, date, amount);
         return;
     }
-    Transaction trans = currNode->data.removeTransaction(transactionID);
-    if (trans.getId() == -1) {
+    // A reader folding the pending cents under the same lock sees the
+    // amount in both or in neither
+    for (nodePtr p = ancestor; p != nullptr; p = p->parent) {
+        unique_lock<mutex> history = lockHistory(p);
+        addPending(p, amount);
+        p->data.recordHistory(date, amount);
+    }
+}
+
+void ForestTree::rollUpHistory(nodePtr ancestor, const BalanceHistory & below) {
+    for (nodePtr p = ancestor; p != nullptr; p = p->parent) {
+        unique_lock<mutex> history = lockHistory(p);
+        p->data.recordHistory(below);
+    }
+}
+
+void ForestTree::settleBalance(nodePtr node) const {
+    if (!node->dirty) {
         return;
     }
-    for(auto & acc : tracked) {
-        acc->updateBalance(trans.getAmount() * (trans.getType() == 'C' ? 1 : -1));
+    Money total = node->ownBalance;
+    for (nodePtr c = node->child; c != nullptr; c = c->sibling) {
+        settleBalance(c);
+        total += c->data.getBalance();
     }
+    node->data.setBalance(total);
+    node->dirty = false;
 }
 
-bool ForestTree::buildTreeFromFile(const string &filePath) {
+void ForestTree::settleAllBalances() const {
+    if (concurrent) {
+        foldAllPending(root, true);
+    }
+    if (!lazyBalances) {
+        return;
+    }
+    for (nodePtr n = root; n != nullptr; n = n->sibling) {
+        settleBalance(n);
+    }
+}
 
-    ifstream file(filePath + (filePath.find(".txt") != string::npos ? "" : ".txt"));
+void ForestTree::setLazyBalances(bool lazy) {
+    unique_lock<shared_mutex> tree = lockTree();
+    if (lazyBalances && !lazy) {
+        settleAllBalances();
+    }
+    lazyBalances = lazy;
+}
 
-    if (!file.is_open()) {
-        cerr << "Error: Could not open input file " << filePath << endl;
-        return false;
+bool ForestTree::usesLazyBalances() const {
+    return lazyBalances;
+}
+
+void ForestTree::setConcurrent(bool enabled) {
+    if (enabled && !concurrent) {
+        settleAllBalances();
+        assignRollupCounters();
+    } else if (!enabled && concurrent) {
+        foldAllPending(root, true);
     }
+    concurrent = enabled;
+}
+
+void ForestTree::setReportThreads(unsigned threadCount) {
+    reportThreads = threadCount;
+}
+
+unsigned ForestTree::getReportThreads() const {
+    return reportThreads;
+}
+
+bool ForestTree::isConcurrent() const {
+    return concurrent;
+}
+
+unique_lock<shared_mutex> ForestTree::lockTree() const {
+    return concurrent ? unique_lock<shared_mutex>(structureLock) : unique_lock<shared_mutex>();
+}
+
+shared_lock<shared_mutex> ForestTree::shareTree() const {
+    return concurrent ? shared_lock<shared_mutex>(structureLock) : shared_lock<shared_mutex>();
+}
 
-    Account acc;
-    string line;
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        istringstream lineStream(line);
-        lineStream >> acc;
-        addAccount(acc);
+size_t ForestTree::accountStripe(nodePtr node) {
+    // Multiplicative hash, so sibling accounts spread over the stripes
+    uint32_t number = node->data.getAccountNumber();
+    return (number * 2654435761u >> 16) % ACCOUNT_LOCK_STRIPES;
+}
+
+unique_lock<mutex> ForestTree::lockAccount(nodePtr node) const {
+    return concurrent ? unique_lock<mutex>(accountLocks[accountStripe(node)]) : unique_lock<mutex>();
+}
+
+unique_lock<mutex> ForestTree::lockHistory(nodePtr node) const {
+    return concurrent ? unique_lock<mutex>(historyLocks[accountStripe(node)]) : unique_lock<mutex>();
+}
+
+size_t ForestTree::transactionStripe(int transactionID) {
+    return (uint32_t)transactionID % TRANSACTION_INDEX_STRIPES;
+}
+
+unique_lock<mutex> ForestTree::lockTransactionIndex(size_t stripe) const {
+    return concurrent ? unique_lock<mutex>(transactionIndexLocks[stripe]) : unique_lock<mutex>();
+}
+
+int ForestTree::transactionOwner(int transactionID) const {
+    size_t stripe = transactionStripe(transactionID);
+    unique_lock<mutex> index = lockTransactionIndex(stripe);
+    return transactionIndex[stripe].find(transactionID);
+}
+
+void ForestTree::assignRollupCounters() {
+    vector<pair<nodePtr, int>> level;
+    for (nodePtr n = root; n != nullptr; n = n->sibling) {
+        level.push_back({n, 0});
     }
+    while (!level.empty()) {
+        nodePtr n = level.back().first;
+        int depth = level.back().second;
+        level.pop_back();
+        if (n->hotCounter == nullptr) {
+            rollupCounters.push_back(make_unique<RollupCounter>());
+            n->hotCounter = rollupCounters.back().get();
+        }
+        if (depth + 1 < HOT_COUNTER_DEPTH) {
+            for (nodePtr c = n->child; c != nullptr; c = c->sibling) {
+                level.push_back({c, depth + 1});
+            }
+        }
+    }
+}
+
+void ForestTree::addPending(nodePtr node, Money amount) {
+    if (node->hotCounter != nullptr) {
+        node->hotCounter->add(amount);
+    } else {
+        node->pendingCents.fetch_add(amount.getCents(), memory_order_relaxed);
+    }
+}
+
+Money ForestTree::pendingBalance(nodePtr node) {
+    Money pending = Money::fromCents(node->pendingCents.load(memory_order_relaxed));
+    if (node->hotCounter != nullptr) {
+        pending += node->hotCounter->sum();
+    }
+    return pending;
+}
+
+Money ForestTree::liveBalance(nodePtr node) const {
+    unique_lock<mutex> account = lockAccount(node);
+    return node->data.getBalance() + pendingBalance(node);
+}
 
-    file.close();
+void ForestTree::foldPending(nodePtr node) {
+    Money pending = Money::fromCents(node->pendingCents.exchange(0, memory_order_relaxed));
+    if (node->hotCounter != nullptr) {
+        pending += node->hotCounter->drain();
+    }
+    node->data.updateBalance(pending);
+}
+
+void ForestTree::foldAllPending(nodePtr start, bool withSiblings) const {
+    traverse(start, 0, withSiblings, [](nodePtr n, int) {
+        foldPending(n);
+    });
+}
+
+bool ForestTree::getAccountBalance(int accountNum, Money & balance) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr node = lookupAccount(accountNum);
+    if (node == nullptr) {
+        return false;
+    }
+    unique_lock<mutex> account = lockAccount(node);
+    settleBalance(node);
+    balance = node->data.getBalance() + pendingBalance(node);
     return true;
 }
 
-void ForestTree::printTransactions(const vector<Transaction>& transactions, int depth, ostream& out) const {
-    if (transactions.empty()) {
-        out << string(depth * 2, ' ') << "No transactions\n";
+Status ForestTree::getBalanceAsOf(int accountNum, int date, Money & balance) const {
+    if (!Transaction::isValidDate(date)) {
+        diagnose(Status::InvalidDate, [&] { return "Invalid date " + to_string(date); });
+        return Status::InvalidDate;
+    }
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr node = lookupAccount(accountNum);
+    if (node == nullptr) {
+        diagnose(Status::AccountNotFound, [] { return string("Account not found!!"); });
+        return Status::AccountNotFound;
+    }
+    // The history lock is taken before folding, so the balance holds exactly
+    // the dated postings the history does (see rollUpDated)
+    unique_lock<mutex> account = lockAccount(node);
+    unique_lock<mutex> history = lockHistory(node);
+    foldPending(node);
+    settleBalance(node);
+    balance = node->data.getBalanceAsOf(date);
+    return Status::Ok;
+}
+
+Status ForestTree::getBalanceChange(int accountNum, int fromDate, int toDate, Money & change) const {
+    if (!Transaction::isValidDate(fromDate) || !Transaction::isValidDate(toDate)) {
+        diagnose(Status::InvalidDate, [&] {
+            return "Invalid date " + to_string(Transaction::isValidDate(fromDate) ? toDate : fromDate);
+        });
+        return Status::InvalidDate;
+    }
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr node = lookupAccount(accountNum);
+    if (node == nullptr) {
+        diagnose(Status::AccountNotFound, [] { return string("Account not found!!"); });
+        return Status::AccountNotFound;
+    }
+    // Answered from the history alone, so pending cents do not matter
+    unique_lock<mutex> history = lockHistory(node);
+    change = node->data.getChangeBetween(fromDate, toDate);
+    return Status::Ok;
+}
+
+Status ForestTree::findAccount(int accountNum, ostream & out) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr node = lookupAccount(accountNum);
+    if (node == nullptr) {
+        diagnose(Status::AccountNotFound, [&] {
+            return "Error: account with number: " + to_string(accountNum) + " not found!!";
+        });
+        return Status::AccountNotFound;
+    }
+    unique_lock<mutex> account = lockAccount(node);
+    foldPending(node);
+    settleBalance(node);
+    out << "Account Found:\n" << node->data;
+    return Status::Ok;
+}
+
+Status ForestTree::addAcountTransaction(const int accountNum, const Transaction & t) {
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr currNode = lookupAccount(accountNum);
+    if (currNode == nullptr) {
+        diagnose(Status::AccountNotFound, [] { return string("Account not found!!"); });
+        return Status::AccountNotFound;
+    }
+    unique_lock<mutex> account = lockAccount(currNode);
+
+    // The index stripe is held from the check until the ID is recorded, so
+    // no other account can take it meanwhile, and postings of one ID reach
+    // the journal in the order they are applied
+    size_t stripe = transactionStripe(t.getId());
+    unique_lock<mutex> index = lockTransactionIndex(stripe);
+    int owner = transactionIndex[stripe].find(t.getId());
+    if (owner != TransactionIndex::NO_ACCOUNT) {
+        diagnose(Status::TransactionExists, [&] {
+            string message = "Transaction " + to_string(t.getId()) + " already exists";
+            return owner == accountNum ? message : message + " in account " + to_string(owner);
+        });
+        return Status::TransactionExists;
+    }
+
+    // Write-ahead: nothing changes unless the posting is journaled
+    if (journal != nullptr && !journal->recordAdd(accountNum, t)) {
+        return journalFailed();
+    }
+    {
+        unique_lock<mutex> history = lockHistory(currNode);
+        currNode->data.addTransaction(t);
+    }
+    transactionIndex[stripe].insert(t.getId(), accountNum);
+    index = unique_lock<mutex>();
+    Money amount = t.getSignedAmount();
+    currNode->ownBalance += amount;
+    if (t.isDated()) {
+        rollUpDated(currNode->parent, t.getDate(), amount);
+    } else {
+        rollUp(currNode->parent, amount);
+    }
+    return Status::Ok;
+}
+
+vector<PostStatus> ForestTree::postBatch(const vector<pair<int, Transaction>> & postings) {
+    vector<PostStatus> results;
+    results.reserve(postings.size());
+    shared_lock<shared_mutex> tree = shareTree();
+
+    // Lock every account the batch touches, in stripe order so that
+    // overlapping batches cannot deadlock
+    vector<unique_lock<mutex>> accounts;
+    if (concurrent) {
+        array<bool, ACCOUNT_LOCK_STRIPES> needed = {};
+        for (const auto & posting : postings) {
+            nodePtr node = lookupAccount(posting.first);
+            if (node != nullptr) {
+                needed[accountStripe(node)] = true;
+            }
+        }
+        for (size_t stripe = 0; stripe < ACCOUNT_LOCK_STRIPES; stripe++) {
+            if (needed[stripe]) {
+                accounts.emplace_back(accountLocks[stripe]);
+            }
+        }
+    }
+
+    // Postings are applied to their accounts and queued in the journal
+    // group; the ancestors follow once the group is committed
+    vector<AccountDelta> deltas;
+    if (journal != nullptr) {
+        journal->beginGroup();
+    }
+    for (const auto & posting : postings) {
+        nodePtr node = lookupAccount(posting.first);
+        if (node == nullptr) {
+            results.push_back(PostStatus::AccountNotFound);
+            continue;
+        }
+        const Transaction & t = posting.second;
+        size_t stripe = transactionStripe(t.getId());
+        unique_lock<mutex> index = lockTransactionIndex(stripe);
+        if (!transactionIndex[stripe].insert(t.getId(), posting.first)) {
+            results.push_back(PostStatus::DuplicateTransaction);
+            continue;
+        }
+        Status status;
+        {
+            unique_lock<mutex> history = lockHistory(node);
+            status = node->data.addTransaction(t);
+        }
+        if (status != Status::Ok) {
+            transactionIndex[stripe].erase(t.getId(), posting.first);
+            results.push_back(PostStatus::DuplicateTransaction);
+            continue;
+        }
+        // Queued while the ID's stripe is held, as in addAcountTransaction;
+        // a journal that is closed or failed takes nothing more
+        if (journal != nullptr && !journal->recordAdd(posting.first, t)) {
+            Transaction removed;
+            {
+                unique_lock<mutex> history = lockHistory(node);
+                node->data.eraseTransaction(t.getId(), removed);
+            }
+            transactionIndex[stripe].erase(t.getId(), posting.first);
+            results.push_back(PostStatus::JournalError);
+            continue;
+        }
+        if (!t.isDated()) {
+            addAccountDelta(deltas, node, t.getSignedAmount());
+        }
+        results.push_back(PostStatus::Posted);
+    }
+
+    if (journal != nullptr && !journal->endGroup()) {
+        if (journal->hasFailed()) {
+            // Some of the batch may be in the journal, and replay would
+            // bring it back: keep it applied rather than roll it back
+            diagnose(Status::JournalError, [] {
+                return string("Error: the journal failed; the last batch is applied but may not be durable!!");
+            });
+        } else {
+            // The commit was cut off the journal: take every posting back
+            for (size_t i = 0; i < postings.size(); i++) {
+                if (results[i] != PostStatus::Posted) {
+                    continue;
+                }
+                nodePtr node = lookupAccount(postings[i].first);
+                int id = postings[i].second.getId();
+                size_t stripe = transactionStripe(id);
+                unique_lock<mutex> index = lockTransactionIndex(stripe);
+                Transaction removed;
+                {
+                    unique_lock<mutex> history = lockHistory(node);
+                    node->data.eraseTransaction(id, removed);
+                }
+                transactionIndex[stripe].erase(id, postings[i].first);
+                results[i] = PostStatus::JournalError;
+            }
+            for (const AccountDelta & delta : deltas) {
+                delta.node->batchSlot = Node::NO_BATCH_SLOT;
+            }
+            journalFailed();
+            return results;
+        }
+    } else if (journal != nullptr && find(results.begin(), results.end(), PostStatus::JournalError) != results.end()) {
+        journalFailed();
+    }
+
+    // Dated postings reach each ancestor's balance and history together;
+    // the undated ones are combined per account
+    for (size_t i = 0; i < postings.size(); i++) {
+        const Transaction & t = postings[i].second;
+        if (results[i] == PostStatus::Posted && t.isDated()) {
+            nodePtr node = lookupAccount(postings[i].first);
+            node->ownBalance += t.getSignedAmount();
+            rollUpDated(node->parent, t.getDate(), t.getSignedAmount());
+        }
+    }
+    applyAccountDeltas(deltas);
+    return results;
+}
+
+void ForestTree::addAccountDelta(vector<AccountDelta> & deltas, nodePtr node, Money amount) {
+    if (node->batchSlot == Node::NO_BATCH_SLOT) {
+        node->batchSlot = (uint32_t)deltas.size();
+        deltas.push_back({node, Money()});
+    }
+    deltas[node->batchSlot].amount += amount;
+}
+
+void ForestTree::applyAccountDeltas(const vector<AccountDelta> & deltas) {
+    // Each ancestor is reached once per changed account below it; walking
+    // the parent links touches the same nodes a per-ancestor sum would
+    for (const AccountDelta & delta : deltas) {
+        nodePtr node = delta.node;
+        node->batchSlot = Node::NO_BATCH_SLOT;
+        node->ownBalance += delta.amount;
+        rollUp(node->parent, delta.amount);
+    }
+}
+
+Status ForestTree::removeAccountTransaction(const int accountNum, const int transactionID) {
+    shared_lock<shared_mutex> tree = shareTree();
+    nodePtr currNode = lookupAccount(accountNum);
+    if (currNode == nullptr) {
+        diagnose(Status::AccountNotFound, [] { return string("Account not found!!"); });
+        return Status::AccountNotFound;
+    }
+    unique_lock<mutex> account = lockAccount(currNode);
+    if (!currNode->data.hasTransaction(transactionID)) {
+        diagnose(Status::TransactionNotFound, [] { return string("Transaction not found!!"); });
+        return Status::TransactionNotFound;
+    }
+
+    // Write-ahead: nothing changes unless the removal is journaled. The
+    // ID's index stripe is held from the record until the ID is released,
+    // so a re-add of the ID by another account is journaled after it
+    size_t stripe = transactionStripe(transactionID);
+    unique_lock<mutex> index = lockTransactionIndex(stripe);
+    if (journal != nullptr && !journal->recordRemove(accountNum, transactionID)) {
+        return journalFailed();
+    }
+    Transaction trans;
+    {
+        unique_lock<mutex> history = lockHistory(currNode);
+        currNode->data.eraseTransaction(transactionID, trans);
+    }
+    transactionIndex[stripe].erase(transactionID, accountNum);
+    index = unique_lock<mutex>();
+    Money amount = -trans.getSignedAmount();
+    currNode->ownBalance += amount;
+    if (trans.isDated()) {
+        rollUpDated(currNode->parent, trans.getDate(), amount);
     } else {
-        for (const auto& transaction : transactions) {
-            transaction.printWithIndentation(depth, out);
+        rollUp(currNode->parent, amount);
+    }
+    return Status::Ok;
+}
+
+Status ForestTree::removeTransaction(const int transactionID) {
+    int accountNum;
+    {
+        shared_lock<shared_mutex> tree = shareTree();
+        accountNum = transactionOwner(transactionID);
+    }
+    if (accountNum == TransactionIndex::NO_ACCOUNT) {
+        diagnose(Status::TransactionNotFound, [] { return string("Transaction not found!!"); });
+        return Status::TransactionNotFound;
+    }
+    return removeAccountTransaction(accountNum, transactionID);
+}
+
+Status ForestTree::findTransaction(int transactionID, int & accountNum, Transaction & found) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    int owner = transactionOwner(transactionID);
+    nodePtr node = owner == TransactionIndex::NO_ACCOUNT ? nullptr : lookupAccount(owner);
+    if (node != nullptr) {
+        unique_lock<mutex> account = lockAccount(node);
+        if (node->data.findTransaction(transactionID, found)) {
+            accountNum = owner;
+            return Status::Ok;
+        }
+    }
+    diagnose(Status::TransactionNotFound, [] { return string("Transaction not found!!"); });
+    return Status::TransactionNotFound;
+}
+
+Status ForestTree::journalFailed() const {
+    diagnose(Status::JournalError, [] {
+        return string("Error: posting could not be written to the journal!!");
+    });
+    return Status::JournalError;
+}
+
+void ForestTree::setJournal(Journal * j) {
+    journal = j;
+}
+
+bool ForestTree::replayJournal(const string &filePath) {
+    unique_lock<shared_mutex> tree = lockTree();
+    MappedFile file;
+    const JournalRecord * records;
+    size_t count;
+    if (!file.open(filePath) || !Journal::readRecords(file, records, count)) {
+        return false;
+    }
+
+    // Consecutive records usually hit the same account, so its net change
+    // is collected locally and added to the batch when the account changes
+    vector<AccountDelta> deltas;
+    nodePtr node = nullptr;
+    int nodeNumber = 0;
+    Money nodeDelta;
+    for (size_t i = 0; i < count; i++) {
+        const JournalRecord & record = records[i];
+        if (node == nullptr || record.accountNumber != nodeNumber) {
+            if (node != nullptr) {
+                addAccountDelta(deltas, node, nodeDelta);
+            }
+            node = lookupAccount(record.accountNumber);
+            nodeNumber = record.accountNumber;
+            nodeDelta = Money();
+            if (node == nullptr) {
+                continue;
+            }
+        }
+
+        if (record.kind == JOURNAL_ADD) {
+            if (!transactionIndex[transactionStripe(record.transactionID)].insert(record.transactionID, nodeNumber)) {
+                continue;
+            }
+            Transaction t(record.transactionID, Money::fromCents(record.amountCents), (char)record.type,
+                          record.date);
+            node->data.addTransaction(t);
+            nodeDelta += t.getSignedAmount();
+            if (t.isDated()) {
+                rollUpHistory(node->parent, t.getDate(), t.getSignedAmount());
+            }
+        } else if (record.kind == JOURNAL_REMOVE) {
+            Transaction removed;
+            if (node->data.eraseTransaction(record.transactionID, removed)) {
+                transactionIndex[transactionStripe(record.transactionID)].erase(record.transactionID, nodeNumber);
+                nodeDelta -= removed.getSignedAmount();
+                if (removed.isDated()) {
+                    rollUpHistory(node->parent, removed.getDate(), -removed.getSignedAmount());
+                }
+            }
+        }
+    }
+    if (node != nullptr) {
+        addAccountDelta(deltas, node, nodeDelta);
+    }
+
+    applyAccountDeltas(deltas);
+    return true;
+}
+
+bool ForestTree::checkpoint(const string &snapshotPath) {
+    // Held across both steps so no posting falls between them
+    unique_lock<shared_mutex> tree = lockTree();
+    if (!writeSnapshot(snapshotPath)) {
+        return false;
+    }
+    return journal == nullptr || journal->reset();
+}
+
+// Parse one "number description balance" record in place. The description
+// is everything between the first and the last space, quotes included.
+static bool parseAccountLine(const char * begin, const char * end,
+                             int & number, string & description, Money & balance) {
+    const char * firstSpace = static_cast<const char *>(memchr(begin, ' ', end - begin));
+    if (firstSpace == nullptr) {
+        return false;
+    }
+    const char * lastSpace = end - 1;
+    while (*lastSpace != ' ') {
+        lastSpace--;
+    }
+    if (lastSpace == firstSpace) {
+        return false;
+    }
+
+    if (from_chars(begin, firstSpace, number).ec != errc()) {
+        return false;
+    }
+    if (!Money::parse(lastSpace + 1, end, balance)) {
+        return false;
+    }
+
+    const char * descEnd = lastSpace;
+    while (descEnd > firstSpace + 1 && descEnd[-1] == ' ') {
+        descEnd--;
+    }
+    if (descEnd == firstSpace + 1) {
+        return false;
+    }
+    description.assign(firstSpace + 1, descEnd);
+    return true;
+}
+
+bool ForestTree::buildTreeFromFile(const string &filePath) {
+    unique_lock<shared_mutex> tree = lockTree();
+
+    MappedFile file;
+    if (!file.open(filePath + (filePath.find(".txt") != string::npos ? "" : ".txt"))) {
+        diagnose(Status::FileError, [&] { return "Error: Could not open input file " + filePath; });
+        return false;
+    }
+
+    // Charts are stored in account-number order, so while the records keep
+    // coming in that order each one is the new last child of its deepest
+    // existing prefix and can be linked without searching the tree. The
+    // first record that breaks this falls back to addAccount for the rest.
+    bool inOrder = (root == nullptr);
+    vector<nodePtr> path;      // Most recently linked node and its ancestors
+    nodePtr lastRoot = nullptr; // Last node of the root sibling list
+
+    int number;
+    Money balance;
+    string description;
+    const char * pos = file.data();
+    const char * fileEnd = pos + file.size();
+    while (pos < fileEnd) {
+        const char * lineEnd = static_cast<const char *>(memchr(pos, '\n', fileEnd - pos));
+        if (lineEnd == nullptr) {
+            lineEnd = fileEnd;
+        }
+        const char * lineStart = pos;
+        pos = lineEnd + 1;
+
+        // Trim trailing whitespace (including '\r' from CRLF files)
+        const char * end = lineEnd;
+        while (end > lineStart && isspace((unsigned char)end[-1])) {
+            end--;
+        }
+        if (end == lineStart) continue;
+
+        if (!parseAccountLine(lineStart, end, number, description, balance)) {
+            diagnose(Status::InvalidFormat, [&] {
+                return "Error: Invalid account format in line: " + string(lineStart, lineEnd);
+            });
+            continue;
+        }
+
+        // Rejected records go through insertAccount for its error reporting;
+        // they leave the tree untouched
+        if (!inOrder || number < 1 || lookupAccount(number) != nullptr ||
+            (number > 9 && lookupAccount(Account::leadingDigit(number)) == nullptr)) {
+            insertAccount(Account(number, description, balance));
+            continue;
+        }
+
+        // Parent = deepest ancestor of the last linked node that prefixes
+        // number. The shallowest node popped on the way is the parent's most
+        // recently linked child, i.e. its last child.
+        nodePtr last = nullptr;
+        while (!path.empty() && !path.back()->data.compAccountNumber(number)) {
+            last = path.back();
+            path.pop_back();
+        }
+        nodePtr parent = path.empty() ? nullptr : path.back();
+        if (parent == nullptr) {
+            last = lastRoot;
+        }
+
+        // The deepest existing prefix must be that same parent
+        nodePtr deepest = nullptr;
+        for (int prefix = number / 10; prefix > 0 && deepest == nullptr; prefix /= 10) {
+            deepest = lookupAccount(prefix);
+        }
+
+        // The previous last child must sort before the new account
+        if (deepest != parent || (last != nullptr && last->data.getAccountNumber() > number)) {
+            inOrder = false;
+            insertAccount(Account(number, description, balance));
+            continue;
+        }
+
+        nodePtr newNode = nodes.create(Account(number, description, balance));
+        newNode->parent = parent;
+        if (last != nullptr) {
+            last->sibling = newNode;
+        } else if (parent != nullptr) {
+            parent->child = newNode;
+        } else {
+            root = newNode;
+        }
+        if (parent == nullptr) {
+            lastRoot = newNode;
+        }
+        attachAccount(newNode);
+        path.push_back(newNode);
+    }
+
+    if (concurrent) {
+        assignRollupCounters();
+    }
+    return true;
+}
+
+template <typename Visit>
+void ForestTree::traverse(nodePtr start, int depth, bool withSiblings, Visit visit) const {
+    if (start == nullptr) return;
+    vector<pair<nodePtr, int>> pending;
+    pending.push_back({start, depth});
+    while (!pending.empty()) {
+        nodePtr node = pending.back().first;
+        int nodeDepth = pending.back().second;
+        pending.pop_back();
+
+        visit(node, nodeDepth);
+
+        // Sibling goes below the child so the whole subtree comes first
+        if (node->sibling != nullptr && (withSiblings || node != start)) {
+            pending.push_back({node->sibling, nodeDepth});
+        }
+        if (node->child != nullptr) {
+            pending.push_back({node->child, nodeDepth + 1});
         }
     }
 }
 
+unsigned ForestTree::reportThreadCount() const {
+    return reportThreads != 0 ? reportThreads : max(1u, thread::hardware_concurrency());
+}
+
+template <typename Job>
+void ForestTree::runParallel(size_t jobCount, unsigned threadCount, Job job) {
+    if (threadCount <= 1 || jobCount <= 1) {
+        for (size_t i = 0; i < jobCount; i++) {
+            job(i);
+        }
+        return;
+    }
+    atomic<size_t> nextJob(0);
+    auto worker = [&]() {
+        for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+            job(i);
+        }
+    };
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(threadCount, jobCount); t++) {
+        workers.emplace_back(worker);
+    }
+    for (thread & w : workers) {
+        w.join();
+    }
+}
+
+template <typename Render>
+void ForestTree::renderReport(ostream& out, Render render) const {
+    unsigned threadCount = reportThreadCount();
+    if (threadCount <= 1) {
+        OutputBuffer buffer(out);
+        traverse(root, 0, true, [&](nodePtr n, int depth) {
+            render(buffer, n, depth);
+        });
+        return;
+    }
+
+    // Tasks in report order: each top-level account on its own, then each
+    // of its child subtrees. Every node belongs to exactly one task.
+    struct Task {
+        nodePtr node;
+        int depth;
+        bool wholeSubtree;
+    };
+    vector<Task> tasks;
+    for (nodePtr top = root; top != nullptr; top = top->sibling) {
+        tasks.push_back({top, 0, false});
+        for (nodePtr c = top->child; c != nullptr; c = c->sibling) {
+            tasks.push_back({c, 1, true});
+        }
+    }
+
+    vector<string> rendered(tasks.size());
+    vector<bool> done(tasks.size(), false);
+    mutex doneLock;
+    condition_variable taskDone;
+    atomic<size_t> nextTask(0);
+
+    auto worker = [&]() {
+        OutputBuffer buffer;
+        for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+            const Task & task = tasks[i];
+            buffer.clear();
+            if (task.wholeSubtree) {
+                traverse(task.node, task.depth, false, [&](nodePtr n, int depth) {
+                    render(buffer, n, depth);
+                });
+            } else {
+                render(buffer, task.node, task.depth);
+            }
+            string text(buffer.view());
+            {
+                lock_guard<mutex> guard(doneLock);
+                rendered[i] = move(text);
+                done[i] = true;
+            }
+            taskDone.notify_all();
+        }
+    };
+    vector<thread> workers;
+    for (unsigned t = 0; t < min<size_t>(threadCount, tasks.size()); t++) {
+        workers.emplace_back(worker);
+    }
+
+    // Write each task as soon as it and everything before it are done
+    for (size_t i = 0; i < tasks.size(); i++) {
+        string text;
+        {
+            unique_lock<mutex> guard(doneLock);
+            taskDone.wait(guard, [&]() { return done[i]; });
+            text = move(rendered[i]);
+        }
+        out.write(text.data(), text.size());
+    }
+    for (thread & w : workers) {
+        w.join();
+    }
+}
+
+void ForestTree::writeTransactions(OutputBuffer& out, const TransactionStore& transactions, int depth) {
+    writeTransactionList(out, depth, transactions.size(), [&](size_t i) { return transactions.at(i); });
+}
+
+void ForestTree::writeChartLine(OutputBuffer& out, nodePtr node) {
+    out.writeInt(node->data.getAccountNumber());
+    out.put(' ');
+    out.write(node->data.getDescription());
+    out.put(' ');
+    out.writeMoney(node->data.getBalance());
+    out.put('\n');
+}
+
+void ForestTree::writeAccount(OutputBuffer& out, nodePtr node, int depth, bool shortDescription,
+                              BlockLayout * layout) const {
+    string_view description = node->data.getDescription();
+    if (shortDescription) {
+        // Check for the condition and remove the starting double quote if necessary
+        if (!description.empty() && description[0] == '"' && (description.size() <= 10 || description[9] != '"')) {
+            description.remove_prefix(1);
+        }
+        description = description.substr(0, 10);
+    }
+
+    const TransactionStore & transactions = node->data.getTransactions();
+    writeAccountBlock(out, depth, node->data.getAccountNumber(), description, node->data.getBalance(),
+                      transactions.size(), [&](size_t i) { return transactions.at(i); }, layout);
+}
+
+void ForestTree::printTransactions(const TransactionStore& transactions, int depth, ostream& out) const {
+    OutputBuffer buffer(out);
+    writeTransactions(buffer, transactions, depth);
+}
+
 void ForestTree::printTree(nodePtr node, int depth, ostream& out) const {
-    if (!node) return;
-    // Print current node with indentation based on depth
-    out << string(depth * 2, '-') << "Account Number: " << node->data.getAccountNumber() << '\n';
-    out << string(depth * 2, '-') << "Description: " << node->data.getDescription() << '\n';
-    out << string(depth * 2, '-') << "Balance: " << node->data.getBalance() << '\n';
-    out << string(depth * 2, '-') << "Transactions:\n";
-    
-    // Call the updated printTransactions
-    printTransactions(node->data.getTransactions(), depth + 1, out);
-    out << '\n';
+    OutputBuffer buffer(out);
+    traverse(node, depth, true, [&](nodePtr n, int d) {
+        writeAccount(buffer, n, d, false);
+    });
+}
 
-    // recall function
-    printTree(node->child, depth + 1, out);
-    printTree(node->sibling, depth, out);
+ForestSnapshot ForestTree::snapshot() const {
+    unique_lock<shared_mutex> tree = lockTree();
+    return ForestSnapshot(*this);
+}
+
+bool ForestTree::saveSnapshot(const string &filePath) const {
+    unique_lock<shared_mutex> tree = lockTree();
+    return writeSnapshot(filePath);
+}
+
+bool ForestTree::writeSnapshot(const string &filePath) const {
+    settleAllBalances();
+
+    vector<SnapshotAccount> accounts;
+    vector<SnapshotTransaction> transactions;
+    string descriptions;
+    accounts.reserve(nodes.size());
+    traverse(root, 0, true, [&](nodePtr n, int depth) {
+        const Account & acc = n->data;
+        const TransactionStore & history = acc.getTransactions();
+        SnapshotAccount record = {};
+        record.accountNumber = acc.getAccountNumber();
+        record.depth = depth;
+        record.balanceCents = acc.getBalance().getCents();
+        record.ownBalanceCents = n->ownBalance.getCents();
+        record.descriptionOffset = descriptions.size();
+        record.descriptionLength = acc.getDescription().size();
+        record.transactionCount = history.size();
+        accounts.push_back(record);
+        descriptions += acc.getDescription();
+        for (size_t pos = 0; pos < history.size(); pos++) {
+            transactions.push_back({history.getId(pos), history.isCredit(pos) ? 'C' : 'D',
+                                    history.getAmountCents(pos), history.getDate(pos), 0});
+        }
+    });
+
+    // Pad the description section to a whole number of words
+    descriptions.resize((descriptions.size() + 7) / 8 * 8, '\0');
+
+    // Payload = everything after the header, checksummed in one piece
+    size_t accountBytes = accounts.size() * sizeof(SnapshotAccount);
+    size_t transactionBytes = transactions.size() * sizeof(SnapshotTransaction);
+    string payload(accountBytes + transactionBytes + descriptions.size(), '\0');
+    memcpy(&payload[0], accounts.data(), accountBytes);
+    memcpy(&payload[accountBytes], transactions.data(), transactionBytes);
+    memcpy(&payload[accountBytes + transactionBytes], descriptions.data(), descriptions.size());
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrderMark = SNAPSHOT_BYTE_ORDER_MARK;
+    header.accountCount = accounts.size();
+    header.transactionCount = transactions.size();
+    header.descriptionBytes = descriptions.size();
+    header.checksum = snapshotChecksum(payload.data(), payload.size());
+
+    // The old snapshot stays intact until the new one is durable under a
+    // temporary name and renamed over it
+    string tempPath = filePath + ".tmp";
+    FILE * file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(payload.data(), 1, payload.size(), file) == payload.size() &&
+                   fflush(file) == 0;
+#ifdef SNAPSHOT_USE_FSYNC
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    written = fclose(file) == 0 && written;
+    error_code error;
+    if (written) {
+        filesystem::rename(tempPath, filePath, error);
+    }
+    if (!written || error) {
+        filesystem::remove(tempPath, error);
+        return false;
+    }
+    return syncDirectory(filePath);
+}
+
+bool ForestTree::syncDirectory(const string &filePath) {
+#ifdef SNAPSHOT_USE_FSYNC
+    string directory = filesystem::path(filePath).parent_path().string();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#else
+    (void)filePath;
+    return true;
+#endif
+}
+
+Status ForestTree::loadSnapshot(const string &filePath) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        diagnose(Status::FileError, [&] { return "Error: Could not open snapshot " + filePath; });
+        return Status::FileError;
+    }
+    auto invalid = [&](const string & reason) {
+        diagnose(Status::InvalidFormat, [&] { return "Error: Invalid snapshot " + filePath + ": " + reason; });
+        return Status::InvalidFormat;
+    };
+    if (file.size() < sizeof(SnapshotHeader)) {
+        return invalid("file is too short");
+    }
+
+    // Validate the header and the section sizes before touching the tree
+    SnapshotHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        return invalid("not a snapshot file");
+    }
+    if (header.byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK) {
+        return invalid("written with the other byte order");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        diagnose(Status::VersionMismatch, [&] {
+            return "Error: Snapshot " + filePath + " has version " + to_string(header.version) +
+                   ", expected " + to_string(SNAPSHOT_VERSION);
+        });
+        return Status::VersionMismatch;
+    }
+    const char * payload = file.data() + sizeof(header);
+    size_t payloadSize = file.size() - sizeof(header);
+    if (header.accountCount > payloadSize / sizeof(SnapshotAccount) ||
+        header.transactionCount > payloadSize / sizeof(SnapshotTransaction) ||
+        header.accountCount * sizeof(SnapshotAccount) +
+        header.transactionCount * sizeof(SnapshotTransaction) +
+        header.descriptionBytes != payloadSize) {
+        return invalid("section sizes do not match the file size");
+    }
+    if (snapshotChecksum(payload, payloadSize) != header.checksum) {
+        diagnose(Status::ChecksumMismatch, [&] { return "Error: Snapshot " + filePath + " fails its checksum"; });
+        return Status::ChecksumMismatch;
+    }
+    const SnapshotAccount * accounts = reinterpret_cast<const SnapshotAccount *>(payload);
+    const SnapshotTransaction * transactions = reinterpret_cast<const SnapshotTransaction *>(
+        payload + header.accountCount * sizeof(SnapshotAccount));
+    const char * descriptions = payload + header.accountCount * sizeof(SnapshotAccount)
+                              + header.transactionCount * sizeof(SnapshotTransaction);
+
+    // Check the records themselves so a bad file cannot build a broken tree
+    uint64_t transactionTotal = 0;
+    vector<int> numbers;
+    numbers.reserve(header.accountCount);
+    for (uint64_t i = 0; i < header.accountCount; i++) {
+        const SnapshotAccount & record = accounts[i];
+        uint64_t maxDepth = i == 0 ? 0 : accounts[i - 1].depth + 1;
+        if (record.depth > maxDepth || record.accountNumber < 1 ||
+            record.descriptionOffset > header.descriptionBytes ||
+            record.descriptionLength > header.descriptionBytes - record.descriptionOffset ||
+            record.transactionCount > header.transactionCount - transactionTotal) {
+            return invalid("bad account record " + to_string(i));
+        }
+        transactionTotal += record.transactionCount;
+        numbers.push_back(record.accountNumber);
+    }
+    if (transactionTotal != header.transactionCount) {
+        return invalid("account records do not cover the transactions");
+    }
+    sort(numbers.begin(), numbers.end());
+    auto repeated = adjacent_find(numbers.begin(), numbers.end());
+    if (repeated != numbers.end()) {
+        diagnose(Status::AccountExists, [&] {
+            return "Error: Snapshot " + filePath + " holds account " + to_string(*repeated) + " twice";
+        });
+        return Status::AccountExists;
+    }
+
+    // The transaction index is built here, where a repeated ID is caught,
+    // and moved into the tree once the file has passed every check
+    array<TransactionIndex, TRANSACTION_INDEX_STRIPES> loadedIndex;
+    for (TransactionIndex & part : loadedIndex) {
+        part.reserve(header.transactionCount / TRANSACTION_INDEX_STRIPES + 1);
+    }
+    const SnapshotTransaction * entry = transactions;
+    for (uint64_t i = 0; i < header.accountCount; i++) {
+        for (uint64_t t = 0; t < accounts[i].transactionCount; t++, entry++) {
+            if (entry->date != 0 && !Transaction::isValidDate(entry->date)) {
+                return invalid("bad date in transaction " + to_string(entry->id));
+            }
+            if (!loadedIndex[transactionStripe(entry->id)].insert(entry->id, accounts[i].accountNumber)) {
+                diagnose(Status::TransactionExists, [&] {
+                    return "Error: Snapshot " + filePath + " holds transaction " + to_string(entry->id) + " twice";
+                });
+                return Status::TransactionExists;
+            }
+        }
+    }
+
+    unique_lock<shared_mutex> tree = lockTree();
+    resetTree();
+    transactionIndex = move(loadedIndex);
+    vector<nodePtr> path;   // path[d] = last node linked at depth d
+    // The balances were saved rolled up; the histories are rebuilt bottom
+    // up, each subtree's merged into its parent once the subtree is complete
+    auto closeSubtrees = [&](size_t depth) {
+        while (path.size() > depth) {
+            nodePtr done = path.back();
+            path.pop_back();
+            if (!path.empty() && done->data.getHistory().bucketCount() != 0) {
+                path.back()->data.recordHistory(done->data.getHistory());
+            }
+        }
+    };
+    const SnapshotTransaction * nextTransaction = transactions;
+    for (uint64_t i = 0; i < header.accountCount; i++) {
+        const SnapshotAccount & record = accounts[i];
+        string description(descriptions + record.descriptionOffset, record.descriptionLength);
+        nodePtr node = nodes.create(Account(record.accountNumber, description,
+                                            Money::fromCents(record.balanceCents)));
+        node->ownBalance = Money::fromCents(record.ownBalanceCents);
+
+        TransactionStore history;
+        history.reserve(record.transactionCount);
+        for (uint64_t t = 0; t < record.transactionCount; t++, nextTransaction++) {
+            history.add(Transaction(nextTransaction->id, Money::fromCents(nextTransaction->amountCents),
+                                    (char)nextTransaction->type, nextTransaction->date));
+        }
+        node->data.restoreTransactions(move(history));
+        // The snapshot keeps no opening balance; it is what the own
+        // balance was before the transactions
+        node->data.setOpeningBalance(node->ownBalance - node->data.getTransactions().signedTotal());
+
+        // A node at depth d follows the last node at depth d as its sibling,
+        // or starts the child list of the last node at depth d - 1
+        size_t depth = record.depth;
+        nodePtr parent = depth == 0 ? nullptr : path[depth - 1];
+        if (path.size() > depth) {
+            path[depth]->sibling = node;
+            closeSubtrees(depth);
+        } else if (parent != nullptr) {
+            parent->child = node;
+        } else {
+            root = node;
+        }
+        node->parent = parent;
+        path.push_back(node);
+        indexAccount(node);
+    }
+    closeSubtrees(0);
+    if (concurrent) {
+        assignRollupCounters();
+    }
+    return Status::Ok;
+}
+
+// Subtree queries
+template <typename Visit>
+void ForestTree::forEachPrefixSubtree(int prefix, Visit visit) const {
+    if (prefix < 1) {
+        return;
+    }
+    // Concurrent trees are never lazy, so this changes nothing under the
+    // shared lock that a concurrent poster could see
+    auto settled = [&](nodePtr node) {
+        settleBalance(node);
+        visit(node);
+    };
+    nodePtr node = lookupAccount(prefix);
+    if (node != nullptr) {
+        settled(node);
+        return;
+    }
+
+    // The matching accounts are children of the deepest account that is a
+    // proper prefix of prefix (or top-level accounts if there is none)
+    nodePtr first = root;
+    for (int ancestor = prefix / 10; ancestor > 0; ancestor /= 10) {
+        nodePtr parent = lookupAccount(ancestor);
+        if (parent != nullptr) {
+            first = parent->child;
+            break;
+        }
+    }
+    for (nodePtr child = first; child != nullptr; child = child->sibling) {
+        if (Account::isPrefix(prefix, child->data.getAccountNumber())) {
+            settled(child);
+        }
+    }
+}
+
+template <typename Visit>
+void ForestTree::walkSubtree(nodePtr top, Visit visit) {
+    nodePtr node = top;
+    while (true) {
+        visit(node);
+        if (node->child != nullptr) {
+            node = node->child;
+            continue;
+        }
+        // Climb to the nearest node below top that has a next sibling
+        while (node != top && node->sibling == nullptr) {
+            node = node->parent;
+        }
+        if (node == top) {
+            return;
+        }
+        node = node->sibling;
+    }
+}
+
+TransactionSplit ForestTree::splitAccount(nodePtr node, int firstId, int lastId) const {
+    // getTransactions puts the store in ID order
+    unique_lock<mutex> account = lockAccount(node);
+    const TransactionStore & transactions = node->data.getTransactions();
+    size_t first, last;
+    transactions.idRange(firstId, lastId, first, last);
+
+    TransactionSplit result;
+    result.accountNumber = node->data.getAccountNumber();
+    transactions.totals(first, last, result.debits, result.credits, result.debitCount);
+    result.creditCount = (last - first) - result.debitCount;
+    return result;
+}
+
+bool ForestTree::summarizeAccounts(int prefix, BalanceSummary &summary) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    summary = BalanceSummary();
+    forEachPrefixSubtree(prefix, [&](nodePtr top) {
+        summary.total += liveBalance(top);
+        walkSubtree(top, [&](nodePtr n) {
+            Money balance = liveBalance(n);
+            if (summary.accounts == 0 || balance < summary.minBalance) {
+                summary.minBalance = balance;
+                summary.minAccount = n->data.getAccountNumber();
+            }
+            if (summary.accounts == 0 || balance > summary.maxBalance) {
+                summary.maxBalance = balance;
+                summary.maxAccount = n->data.getAccountNumber();
+            }
+            summary.accounts++;
+        });
+    });
+    return summary.accounts != 0;
+}
+
+vector<AccountBalance> ForestTree::topAccounts(int prefix, size_t count, bool largest) const {
+    // Bounded heap whose front is the worst of the best count seen so far;
+    // seen orders ties by chart position
+    struct Candidate {
+        Money balance;
+        size_t seen;
+        int accountNumber;
+    };
+    auto better = [&](const Candidate & a, const Candidate & b) {
+        if (a.balance != b.balance) {
+            return largest ? a.balance > b.balance : a.balance < b.balance;
+        }
+        return a.seen < b.seen;
+    };
+    vector<Candidate> heap;
+    if (count != 0) {
+        shared_lock<shared_mutex> tree = shareTree();
+        size_t seen = 0;
+        forEachPrefixSubtree(prefix, [&](nodePtr top) {
+            walkSubtree(top, [&](nodePtr n) {
+                Candidate candidate{liveBalance(n), seen++, n->data.getAccountNumber()};
+                if (heap.size() < count) {
+                    heap.push_back(candidate);
+                    push_heap(heap.begin(), heap.end(), better);
+                } else if (better(candidate, heap.front())) {
+                    pop_heap(heap.begin(), heap.end(), better);
+                    heap.back() = candidate;
+                    push_heap(heap.begin(), heap.end(), better);
+                }
+            });
+        });
+    }
+    sort_heap(heap.begin(), heap.end(), better);
+
+    vector<AccountBalance> top;
+    top.reserve(heap.size());
+    for (const Candidate & candidate : heap) {
+        top.push_back({candidate.accountNumber, candidate.balance});
+    }
+    return top;
+}
+
+TransactionSplit ForestTree::splitTransactions(int prefix, int firstId, int lastId) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    TransactionSplit total;
+    forEachPrefixSubtree(prefix, [&](nodePtr top) {
+        walkSubtree(top, [&](nodePtr n) {
+            TransactionSplit accountSplit = splitAccount(n, firstId, lastId);
+            total.debitCount += accountSplit.debitCount;
+            total.creditCount += accountSplit.creditCount;
+            total.debits += accountSplit.debits;
+            total.credits += accountSplit.credits;
+        });
+    });
+    return total;
+}
+
+vector<TransactionSplit> ForestTree::splitTransactionsByAccount(int prefix, int firstId, int lastId) const {
+    shared_lock<shared_mutex> tree = shareTree();
+    vector<TransactionSplit> splits;
+    forEachPrefixSubtree(prefix, [&](nodePtr top) {
+        walkSubtree(top, [&](nodePtr n) {
+            TransactionSplit accountSplit = splitAccount(n, firstId, lastId);
+            if (accountSplit.debitCount + accountSplit.creditCount != 0) {
+                splits.push_back(accountSplit);
+            }
+        });
+    });
+    return splits;
+}
+
+// Auditing
+AuditReport ForestTree::auditBalances(AuditKernel kernel) const {
+    unique_lock<shared_mutex> tree = lockTree();
+    settleAllBalances();
+
+    // Preorder with each node's parent position, so a reverse pass visits
+    // every subaccount before its parent
+    vector<nodePtr> order;
+    vector<size_t> parentPos;
+    vector<size_t> lastAtDepth;   // lastAtDepth[d] = position of the last node seen at depth d
+    traverse(root, 0, true, [&](nodePtr n, int depth) {
+        lastAtDepth.resize(depth);
+        parentPos.push_back(depth == 0 ? TransactionStore::npos : lastAtDepth[depth - 1]);
+        lastAtDepth.push_back(order.size());
+        order.push_back(n);
+    });
+
+    AuditReport report;
+    report.accounts = order.size();
+    vector<Money> totals(order.size());
+    vector<AuditMismatch> found;
+    for (size_t i = order.size(); i-- > 0;) {
+        nodePtr n = order[i];
+        const TransactionStore & store = n->data.getTransactions();
+        report.transactions += store.size();
+
+        // The rolled-up mismatch is pushed first so that reversing found
+        // lists the own-balance mismatch of an account before it
+        Money own = n->data.getOpeningBalance() + store.signedTotal(kernel);
+        totals[i] += own;
+        if (totals[i] != n->data.getBalance()) {
+            found.push_back({n->data.getAccountNumber(), true, totals[i], n->data.getBalance()});
+        }
+        if (own != n->ownBalance) {
+            found.push_back({n->data.getAccountNumber(), false, own, n->ownBalance});
+        }
+        if (parentPos[i] != TransactionStore::npos) {
+            totals[parentPos[i]] += totals[i];
+        }
+    }
+    report.mismatches.assign(found.rbegin(), found.rend());
+    return report;
 }
 
 ostream& operator<<(ostream& out, const ForestTree& tree) {
+    unique_lock<shared_mutex> lock = tree.lockTree();
     if (tree.root == nullptr) {
         out << "tree empty";
     } else {
-        tree.printTree(tree.root, 0, out);
+        tree.settleAllBalances();
+        tree.renderReport(out, [&](OutputBuffer & buffer, ForestTree::nodePtr n, int depth) {
+            tree.writeAccount(buffer, n, depth, false);
+        });
     }
     return out;
 }
 
 void ForestTree::printAccountRecursive(nodePtr node, int depth, ostream& out) const {
-    if (!node) return;
-    string description = node->data.getDescription();
-    // Check for the condition and remove the starting double quote if necessary
-    if (!description.empty() && description[0] == '"' && (description.size() <= 10 || description[9] != '"')) {
-        description = description.substr(1); // Remove the starting double quote
-    }
-    // Print current node with indentation based on depth
-    out << string(depth * 2, '-') << "Account Number: " << node->data.getAccountNumber() << '\n';
-    out << string(depth * 2, '-') << "Description: " << description.substr(0, 10)<< '\n';
-    out << string(depth * 2, '-') << "Balance: " << node->data.getBalance() << '\n';
-    out << string(depth * 2, '-') << "Transactions:\n";
-    
-    // Call the updated printTransactions
-    printTransactions(node->data.getTransactions(), depth + 1, out);
-    
-    out << '\n';
-    // recall function
-    printAccountRecursive(node->child, depth + 1, out);
-    if (depth != 0) {
-        printAccountRecursive(node->sibling, depth, out);
+    OutputBuffer buffer(out);
+    traverse(node, depth, depth != 0, [&](nodePtr n, int d) {
+        writeAccount(buffer, n, d, true);
+    });
+}
+
+Status ForestTree::printAccount(int accountNum) const {
+    unique_lock<shared_mutex> tree = lockTree();
+    nodePtr node = lookupAccount(accountNum);
+    if (node == nullptr) {
+        diagnose(Status::AccountNotFound, [] { return string("Account not found!!"); });
+        return Status::AccountNotFound;
     }
+
+    if (concurrent) {
+        foldAllPending(node, false);
+    }
+    settleBalance(node);
+    string folderName = "Print_results/";
+    if (!filesystem::exists(folderName)) {
+        filesystem::create_directory(folderName);
+    }
+    string fileName = folderName + "Account " + to_string(accountNum) + ".txt";
+    ofstream outFile(fileName);
+    if (!outFile.is_open()) {
+        diagnose(Status::FileError, [&] { return "Error: Unable to open file: " + fileName; });
+        return Status::FileError;
+    }
+    printAccountRecursive(node, 0, outFile);
+    return Status::Ok;
 }
 
-void ForestTree::printAccount(int accountNum) const {
-    vector<nodePtr> res = searchAccountWithTracking(accountNum);
- 
-    if (res[0] != nullptr && res[0]->data.getAccountNumber() == accountNum) {
-        string folderName = "Print_results/";
-        if (!filesystem::exists(folderName)) {
-            filesystem::create_directory(folderName);
-        }
-        ofstream outFile(folderName + "Account " + to_string(accountNum) + ".txt");
-        if (!outFile.is_open()) {
-            cerr << "Error: Unable to open file: \n";
-            return;
+size_t ForestTree::exportAccountReports(const vector<int> & accountNumbers) const {
+    unique_lock<shared_mutex> tree = lockTree();
+    settleAllBalances();
+    vector<nodePtr> requested;
+    requested.reserve(accountNumbers.size());
+    for (int number : accountNumbers) {
+        nodePtr node = lookupAccount(number);
+        if (node != nullptr) {
+            requested.push_back(node);
+        } else {
+            diagnose(Status::AccountNotFound, [&] {
+                return "Error: account with number: " + to_string(number) + " not found!!";
+            });
         }
-       printAccountRecursive(res[0],0,outFile);
-       cout << "File printed successfully!!\n";
-       return;
     }
-    cerr << "Account not found!!\n";
+    return exportReports(requested);
+}
+
+Status ForestTree::exportAllAccountReports() const {
+    unique_lock<shared_mutex> tree = lockTree();
+    settleAllBalances();
+    vector<nodePtr> requested;
+    requested.reserve(nodes.size());
+    traverse(root, 0, true, [&](nodePtr n, int) {
+        requested.push_back(n);
+    });
+    return exportReports(requested) == requested.size() ? Status::Ok : Status::FileError;
+}
+
+// Appends text with every line prefixed by width copies of fill; a last
+// line without a newline is prefixed too
+static void writeIndented(OutputBuffer & out, string_view text, char fill, int width) {
+    if (width == 0) {
+        out.write(text);
+        return;
+    }
+    while (!text.empty()) {
+        size_t lineEnd = text.find('\n');
+        size_t lineLength = lineEnd == string_view::npos ? text.size() : lineEnd + 1;
+        out.fill(fill, width);
+        out.write(text.substr(0, lineLength));
+        text.remove_prefix(lineLength);
+    }
+}
+
+size_t ForestTree::exportReports(vector<nodePtr> & requested) const {
+    // One traversal, in report order, over the subtrees of the requested
+    // accounts that have no requested ancestor; nested reports are
+    // contiguous ranges of it. pending holds the requested nodes not yet
+    // reached by the traversal.
+    unordered_set<nodePtr> pending(requested.begin(), requested.end());
+    struct Rendered {
+        nodePtr node;
+        int depth;          // Depth below the outermost requested account
+        size_t end;         // One past the last node of this node's subtree
+        size_t chunk;       // Chunk holding the rendering
+        size_t offset;      // Start of the rendering in its chunk
+        BlockLayout layout; // Indentation points, relative to offset
+        size_t length;      // Bytes of the whole rendering
+    };
+    vector<Rendered> order;
+    vector<size_t> reports;   // Positions in order of the requested nodes
+    for (nodePtr node : requested) {
+        bool outermost = pending.count(node) > 0;
+        for (nodePtr p = node->parent; p != nullptr && outermost; p = p->parent) {
+            outermost = pending.count(p) == 0;
+        }
+        if (!outermost) {
+            continue;
+        }
+        size_t first = order.size();
+        traverse(node, 0, false, [&](nodePtr n, int depth) {
+            if (pending.erase(n) > 0) {
+                reports.push_back(order.size());
+            }
+            order.push_back({n, depth, 0, 0, 0, 0, 0});
+        });
+
+        // Subtree ends: a node's subtree stops at the next node no deeper
+        vector<size_t> open;
+        for (size_t i = first; i < order.size(); i++) {
+            while (!open.empty() && order[open.back()].depth >= order[i].depth) {
+                order[open.back()].end = i;
+                open.pop_back();
+            }
+            open.push_back(i);
+        }
+        for (size_t i : open) {
+            order[i].end = order.size();
+        }
+    }
+
+    // Render every node once, at depth 0, in parallel chunks
+    unsigned threadCount = reportThreadCount();
+    size_t chunkCount = min<size_t>(order.size(), threadCount * 4);
+    vector<string> chunks(chunkCount);
+    runParallel(chunkCount, threadCount, [&](size_t c) {
+        OutputBuffer buffer;
+        for (size_t i = order.size() * c / chunkCount; i < order.size() * (c + 1) / chunkCount; i++) {
+            Rendered & r = order[i];
+            r.chunk = c;
+            r.offset = buffer.view().size();
+            writeAccount(buffer, r.node, 0, true, &r.layout);
+            r.length = buffer.view().size() - r.offset;
+            for (size_t & start : r.layout.headerStarts) {
+                start -= r.offset;
+            }
+            r.layout.bodyStart -= r.offset;
+        }
+        chunks[c] = string(buffer.view());
+    });
+
+    // Assemble and write the reports; the directory is checked once, and a
+    // directory that cannot be created shows up as files not written
+    string folderName = "Print_results/";
+    error_code folderError;
+    if (!filesystem::exists(folderName, folderError)) {
+        filesystem::create_directory(folderName, folderError);
+    }
+    atomic<size_t> written(0);
+    runParallel(reports.size(), threadCount, [&](size_t k) {
+        const Rendered & top = order[reports[k]];
+        OutputBuffer buffer;
+        for (size_t i = reports[k]; i < top.end; i++) {
+            const Rendered & r = order[i];
+            int width = (r.depth - top.depth) * 2;
+            string_view text = string_view(chunks[r.chunk]).substr(r.offset, r.length);
+            // Dashes go only where writeAccountBlock indents, so a
+            // description holding newlines comes out as printAccount's
+            for (int line = 0; line < 4; line++) {
+                size_t start = r.layout.headerStarts[line];
+                size_t end = line < 3 ? r.layout.headerStarts[line + 1] : r.layout.bodyStart;
+                buffer.fill('-', width);
+                buffer.write(text.substr(start, end - start));
+            }
+            size_t body = r.layout.bodyStart;
+            writeIndented(buffer, text.substr(body, r.length - body - 1), ' ', width);
+            buffer.put('\n');
+        }
+        ofstream outFile(folderName + "Account " + to_string(top.node->data.getAccountNumber()) + ".txt",
+                         ios::binary);
+        string_view report = buffer.view();
+        if (outFile.write(report.data(), report.size())) {
+            written++;
+        }
+    });
+    if (written < reports.size()) {
+        diagnose(Status::FileError, [&] {
+            return "Error: Unable to write " + to_string(reports.size() - written) + " of " +
+                   to_string(reports.size()) + " report files in " + folderName;
+        });
+    }
+    return written;
 }
 
 bool ForestTree::printTreeIntoFile(const string& fileName) {
@@ -263,29 +1767,28 @@ bool ForestTree::printTreeIntoFile(const string& fileName) {
     }
     ofstream outFile(folderName + fileName + (fileName.find(".txt") != string::npos ? "" : ".txt"));
     if (!outFile.is_open()) {
-        cerr << "Error: Unable to open file: " << fileName << endl;
+        diagnose(Status::FileError, [&] { return "Error: Unable to open file: " + fileName; });
         return false;
     }
         
+    unique_lock<shared_mutex> tree = lockTree();
     if (root == nullptr) {
         outFile << "empty tree";
         outFile.close();
         return false;
     }
     
-    printTreeRecursive(root, outFile);
+    settleAllBalances();
+    renderReport(outFile, [](OutputBuffer & buffer, nodePtr n, int) {
+        writeChartLine(buffer, n);
+    });
     outFile.close();
     return true;
 }
 
 void ForestTree::printTreeRecursive(nodePtr node, ostream& out) {
-    if (!node) return;
-    
-    out << node->data.getAccountNumber()<<" "
-        << node->data.getDescription()<<" "
-        << node->data.getBalance() << '\n';
-
-    // Print child and sibling nodes
-    printTreeRecursive(node->child, out);
-    printTreeRecursive(node->sibling, out);
-}
\ No newline at end of file
+    OutputBuffer buffer(out);
+    traverse(node, 0, true, [&](nodePtr n, int) {
+        writeChartLine(buffer, n);
+    });
+}
@@ -7,8 +7,14 @@
   Basic functionalities include:
      - Adding accounts
      - Managing transactions associated with accounts
+     - Finding and removing transactions by ID alone through a global index
+     - Balances as of a date and changes between dates, in logarithmic time
+     - Auditing every balance against a recomputation from the transactions
+     - Balance and debit/credit queries over account-number prefixes
      - Searching for accounts with tracking
-     - Printing the tree structure or individual accounts to console or file
+     - Printing the tree structure or individual accounts to a stream or file
+     - Reporting failures as Status codes, with messages going only to the
+       installed DiagnosticSink (see Status.h)
      - Building the tree structure from an input file
      - Writing the tree structure to an output file
 
@@ -20,11 +26,64 @@
 #include <sstream>
 #include <math.h>
 #include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
 #include "Account.h"
+#include "MappedFile.h"
+#include "ObjectPool.h"
+#include "ForestSnapshot.h"
+#include "SnapshotFormat.h"
+#include "Journal.h"
+#include "RollupCounter.h"
+#include "BalanceAudit.h"
+#include "TransactionIndex.h"
 
 using namespace std;
 
+/******** Batch Posting Results ********/
+enum class PostStatus {
+    Posted,                // Transaction was added to the account
+    AccountNotFound,       // No account with the given number
+    DuplicateTransaction,  // Some account already holds a transaction with this ID
+    JournalError           // The journal could not record the posting; it was not applied
+};
+
+/******** Subtree Query Results ********/
+struct BalanceSummary {
+    size_t accounts = 0;    // Accounts whose number starts with the prefix
+    Money total;            // Their combined balance (each subtree counted once)
+    Money minBalance;       // Lowest balance of a single account
+    Money maxBalance;       // Highest balance of a single account
+    int minAccount = 0;     // Account holding minBalance
+    int maxAccount = 0;     // Account holding maxBalance
+};
+
+struct AccountBalance {
+    int accountNumber;      // Account
+    Money balance;          // Its rolled-up balance
+};
+
+struct TransactionSplit {
+    int accountNumber = 0;  // Account, or 0 for a total over several accounts
+    size_t debitCount = 0;  // Debits in the ID range
+    size_t creditCount = 0; // Credits in the ID range
+    Money debits;           // Sum of those debits
+    Money credits;          // Sum of those credits
+};
+
 class ForestTree {
+    friend class ForestSnapshot;
+
 private:
     /******** Nested Node Class ********/
     class Node {
@@ -32,19 +91,505 @@ private:
         Account data;    // Account data stored in the node
         Node* sibling;   // Pointer to the sibling node
         Node* child;     // Pointer to the child node
+        Node* parent;    // Pointer to the node whose child list holds this one
+        Money ownBalance;  // Opening balance plus this account's own transactions
+        bool dirty;        // Lazy mode: data's balance misses changes made below
+        uint32_t batchSlot;  // Position in the delta list of the batch being applied, or NO_BATCH_SLOT
+        atomic<int64_t> pendingCents;  // Concurrent mode: roll-ups not yet in data's balance
+        RollupCounter *hotCounter;     // Concurrent mode: sharded roll-ups for top-level nodes, or nullptr
+
+        static const uint32_t NO_BATCH_SLOT = 0xFFFFFFFFu;
 
-        Node(const Account & acc) : data(acc), sibling(nullptr), child(nullptr) {};
+        Node(const Account & acc)
+         : data(acc), sibling(nullptr), child(nullptr), parent(nullptr),
+           ownBalance(acc.getBalance()), dirty(false), batchSlot(NO_BATCH_SLOT), pendingCents(0),
+           hotCounter(nullptr) {};
         /*----------------------------------------------------------------------
         Constructs a Node containing an Account.
 
         Precondition:  acc is a valid Account object.
-        Postcondition: Node is initialized with given Account, and its sibling
-        and child pointers are set to nullptr.
+        Postcondition: Node is initialized with given Account, and its sibling,
+        child and parent pointers are set to nullptr.
         -----------------------------------------------------------------------*/
     };
 
     typedef Node* nodePtr; // Pointer type alias for Node
     nodePtr root;          // Root of the ForestTree
+    ObjectPool<Node> nodes; // Owns every node of the tree
+
+    /******** Account Index ********/
+    static const int DIRECT_INDEX_LIMIT = 1000000; // Numbers below this are direct-indexed
+
+    vector<nodePtr> directIndex;                 // accountNumber -> node, grown on demand
+    unordered_map<int, nodePtr> overflowIndex;   // accountNumber -> node for larger numbers
+
+    nodePtr lookupAccount(int accountNumber) const;
+    /*----------------------------------------------------------------------
+    Finds the node holding an account using the account index.
+
+    Precondition:  None.
+    Postcondition: Returns the node whose account number is accountNumber,
+    or nullptr if no such account exists. The tree is not walked.
+    -----------------------------------------------------------------------*/
+
+    void indexAccount(nodePtr node);
+    /*----------------------------------------------------------------------
+    Registers a newly linked node in the account index.
+
+    Precondition:  node is linked into the tree and its number is unique.
+    Postcondition: lookupAccount(node's number) returns node.
+    -----------------------------------------------------------------------*/
+
+    void attachAccount(nodePtr node);
+    /*----------------------------------------------------------------------
+    Finishes adding a node that has just been linked into the tree.
+
+    Precondition:  node is linked into the tree, its number is unique and
+    no other account holds any of its transaction IDs.
+    Postcondition: node and its transaction IDs are indexed and its
+    opening balance is rolled up into its ancestors.
+    -----------------------------------------------------------------------*/
+
+    /******** Transaction Index ********/
+    static const size_t TRANSACTION_INDEX_STRIPES = 64;   // Independently locked parts of the index
+
+    array<TransactionIndex, TRANSACTION_INDEX_STRIPES> transactionIndex;   // Transaction ID -> account number
+    mutable array<mutex, TRANSACTION_INDEX_STRIPES> transactionIndexLocks; // Guard each part of the index
+
+    static size_t transactionStripe(int transactionID);
+    /*----------------------------------------------------------------------
+    Finds the part of the transaction index that holds an ID.
+
+    Precondition:  None.
+    Postcondition: Returns a stripe derived from the ID, so consecutive
+    IDs get different stripes.
+    -----------------------------------------------------------------------*/
+
+    unique_lock<mutex> lockTransactionIndex(size_t stripe) const;
+    /*----------------------------------------------------------------------
+    Takes one part of the transaction index.
+
+    Precondition:  The structure is held (shareTree or lockTree), and the
+    calling thread holds no history lock and no other index lock. An
+    account lock may be held; it must then have been taken first.
+    Postcondition: In concurrent mode, returns a hold on the stripe;
+    otherwise returns an empty lock.
+    -----------------------------------------------------------------------*/
+
+    int transactionOwner(int transactionID) const;
+    /*----------------------------------------------------------------------
+    Finds the account holding a transaction ID.
+
+    Precondition:  The structure is held (shareTree or lockTree), and the
+    calling thread holds no index lock.
+    Postcondition: Returns the account number, or
+    TransactionIndex::NO_ACCOUNT if no account holds the ID.
+    -----------------------------------------------------------------------*/
+
+    /******** Balance Roll-up ********/
+    bool lazyBalances;     // True if ancestor balances are computed on demand
+
+    void rollUp(nodePtr ancestor, Money amount);
+    /*----------------------------------------------------------------------
+    Propagates a change made below ancestor to ancestor and everything
+    above it.
+
+    Precondition:  ancestor is nullptr or a node of this tree.
+    Postcondition: Eager mode: each balance on the chain changes by amount.
+    Lazy mode: the chain is marked dirty, stopping at the first node that
+    already is, so the cost does not depend on tree depth.
+    -----------------------------------------------------------------------*/
+
+    void rollUpHistory(nodePtr ancestor, int date, Money amount);
+    /*----------------------------------------------------------------------
+    Records a dated change made below ancestor in the balance history of
+    ancestor and everything above it.
+
+    Precondition:  ancestor is nullptr or a node of this tree, and
+    Transaction::isValidDate(date). The calling thread holds no history
+    lock.
+    Postcondition: Each history on the chain includes amount on date. In
+    concurrent mode each one is updated under its own history lock.
+    -----------------------------------------------------------------------*/
+
+    void rollUpDated(nodePtr ancestor, int date, Money amount);
+    /*----------------------------------------------------------------------
+    Rolls a dated change made below ancestor up into the balances and the
+    histories of ancestor and everything above it.
+
+    Precondition:  As rollUpHistory.
+    Postcondition: As rollUp followed by rollUpHistory. In concurrent mode
+    each ancestor's pending cents and history change together under its
+    history lock, so getBalanceAsOf never sees one without the other.
+    -----------------------------------------------------------------------*/
+
+    void rollUpHistory(nodePtr ancestor, const BalanceHistory &below);
+    /*----------------------------------------------------------------------
+    Records a whole history from below ancestor in the balance history of
+    ancestor and everything above it.
+
+    Precondition:  ancestor is nullptr or a node of this tree, below is
+    not the history of a node on the chain, and the calling thread holds
+    no history lock.
+    Postcondition: Each history on the chain includes every amount of
+    below, merged in one pass per history.
+    -----------------------------------------------------------------------*/
+
+    void settleBalance(nodePtr node) const;
+    /*----------------------------------------------------------------------
+    Brings a dirty node's rolled-up balance up to date.
+
+    Precondition:  node is a node of this tree.
+    Postcondition: node and every dirty node below it hold their own balance
+    plus the balances of their children, and are clean again.
+    -----------------------------------------------------------------------*/
+
+    void settleAllBalances() const;
+    /*----------------------------------------------------------------------
+    Brings every rolled-up balance in the tree up to date.
+
+    Precondition:  None.
+    Postcondition: No node is dirty.
+    -----------------------------------------------------------------------*/
+
+    struct AccountDelta {
+        nodePtr node;    // Account changed by the batch
+        Money amount;    // Net change of its own transactions
+    };
+
+    static void addAccountDelta(vector<AccountDelta> &deltas, nodePtr node, Money amount);
+    /*----------------------------------------------------------------------
+    Collects a change to an account's own transactions.
+
+    Precondition:  node's account is held, and node's batchSlot is
+    NO_BATCH_SLOT or its position in deltas.
+    Postcondition: amount is added to node's entry in deltas, which is
+    appended the first time, without hashing.
+    -----------------------------------------------------------------------*/
+
+    void applyAccountDeltas(const vector<AccountDelta> &deltas);
+    /*----------------------------------------------------------------------
+    Applies the net change of several accounts' own transactions.
+
+    Precondition:  The accounts' own balances in data already include the
+    changes; ownBalance and the ancestors do not yet. The accounts are
+    held and listed once each.
+    Postcondition: ownBalance is updated, every ancestor receives one
+    delta per changed account below it (eager and concurrent modes) or is
+    marked dirty (lazy mode), and the batch slots are cleared.
+    -----------------------------------------------------------------------*/
+
+    /******** Concurrency ********/
+    static const size_t ACCOUNT_LOCK_STRIPES = 256;   // Locks shared by accounts
+    static const int HOT_COUNTER_DEPTH = 2;           // Levels whose roll-ups are sharded
+
+    bool concurrent;                          // True if public calls synchronize
+    mutable shared_mutex structureLock;       // Shared by postings, exclusive for structural changes
+    mutable array<mutex, ACCOUNT_LOCK_STRIPES> accountLocks;  // Guard each account's own data
+    mutable array<mutex, ACCOUNT_LOCK_STRIPES> historyLocks;  // Guard each account's balance history
+    vector<unique_ptr<RollupCounter>> rollupCounters;  // Owns the nodes' hot counters
+
+    unique_lock<shared_mutex> lockTree() const;
+    /*----------------------------------------------------------------------
+    Takes the tree for a structural change or a whole-tree read.
+
+    Precondition:  The calling thread holds no lock of this tree.
+    Postcondition: In concurrent mode, returns an exclusive hold on the
+    structure; otherwise returns an empty lock.
+    -----------------------------------------------------------------------*/
+
+    shared_lock<shared_mutex> shareTree() const;
+    /*----------------------------------------------------------------------
+    Takes the tree for work on single accounts.
+
+    Precondition:  The calling thread holds no lock of this tree.
+    Postcondition: In concurrent mode, returns a shared hold on the
+    structure, so accounts cannot be added meanwhile; otherwise returns an
+    empty lock.
+    -----------------------------------------------------------------------*/
+
+    static size_t accountStripe(nodePtr node);
+    /*----------------------------------------------------------------------
+    Finds the lock stripe of an account.
+
+    Precondition:  node is a node of this tree.
+    Postcondition: Returns a stripe derived from the account number, so
+    neighbouring accounts usually get different stripes.
+    -----------------------------------------------------------------------*/
+
+    unique_lock<mutex> lockAccount(nodePtr node) const;
+    /*----------------------------------------------------------------------
+    Takes one account's own data.
+
+    Precondition:  The structure is held (shareTree or lockTree).
+    Postcondition: In concurrent mode, returns a hold on the account's
+    stripe; its transactions, own balance and balance may then be read
+    and updated. Otherwise returns an empty lock.
+    -----------------------------------------------------------------------*/
+
+    unique_lock<mutex> lockHistory(nodePtr node) const;
+    /*----------------------------------------------------------------------
+    Takes one account's balance history.
+
+    Precondition:  The structure is held (shareTree or lockTree), and the
+    calling thread holds no other history lock. An account lock may be
+    held; it must then have been taken first.
+    Postcondition: In concurrent mode, returns a hold on the account's
+    history stripe, which postings below the account also take to roll
+    their dates up. Otherwise returns an empty lock.
+    -----------------------------------------------------------------------*/
+
+    void assignRollupCounters();
+    /*----------------------------------------------------------------------
+    Gives the top levels of the tree sharded roll-up counters.
+
+    Precondition:  The structure is held exclusively.
+    Postcondition: Every node less than HOT_COUNTER_DEPTH levels deep has
+    a hotCounter. Nodes that already had one keep it.
+    -----------------------------------------------------------------------*/
+
+    static void addPending(nodePtr node, Money amount);
+    /*----------------------------------------------------------------------
+    Rolls a change made below node into it without locking.
+
+    Precondition:  None.
+    Postcondition: amount is added to the node's hot counter, or to its
+    atomic pendingCents if it has none.
+    -----------------------------------------------------------------------*/
+
+    static Money pendingBalance(nodePtr node);
+    /*----------------------------------------------------------------------
+    Reads the roll-ups a node has not yet folded in.
+
+    Precondition:  None.
+    Postcondition: Returns pendingCents plus the hot counter's sum.
+    -----------------------------------------------------------------------*/
+
+    Money liveBalance(nodePtr node) const;
+    /*----------------------------------------------------------------------
+    Reads a node's rolled-up balance without changing the node.
+
+    Precondition:  The tree is held at least shared and its balances are
+    settled; the calling thread holds no account lock.
+    Postcondition: Returns the balance plus the pending roll-ups, read
+    under the node's account lock, so concurrent posting goes on.
+    -----------------------------------------------------------------------*/
+
+    static void foldPending(nodePtr node);
+    /*----------------------------------------------------------------------
+    Moves a node's pending roll-ups into its balance.
+
+    Precondition:  The node's account is held (lockAccount or lockTree).
+    Postcondition: data's balance includes every roll-up drained from the
+    node; later roll-ups stay pending.
+    -----------------------------------------------------------------------*/
+
+    void foldAllPending(nodePtr start, bool withSiblings) const;
+    /*----------------------------------------------------------------------
+    Folds the pending roll-ups of a whole subtree.
+
+    Precondition:  The structure is held exclusively.
+    Postcondition: Every node visited from start, as by traverse, holds
+    its complete balance.
+    -----------------------------------------------------------------------*/
+
+    /******** Unlocked Implementations ********/
+    Status insertAccount(const Account &acc);
+    /*----------------------------------------------------------------------
+    Body of addAccount; the caller holds the structure exclusively.
+    -----------------------------------------------------------------------*/
+
+    void resetTree();
+    /*----------------------------------------------------------------------
+    Body of clear; the caller holds the structure exclusively.
+    -----------------------------------------------------------------------*/
+
+    bool writeSnapshot(const string &filePath) const;
+    /*----------------------------------------------------------------------
+    Body of saveSnapshot; the caller holds the structure exclusively.
+    -----------------------------------------------------------------------*/
+
+    static bool syncDirectory(const string &filePath);
+    /*----------------------------------------------------------------------
+    Makes a rename into a file's directory durable.
+
+    Precondition:  None.
+    Postcondition: The directory holding filePath is synced where the
+    platform supports it. Returns false if that failed.
+    -----------------------------------------------------------------------*/
+
+    /******** Journaling ********/
+    Journal *journal;      // Receives every successful posting, or nullptr
+
+    Status journalFailed() const;
+    /*----------------------------------------------------------------------
+    Reports that a posting could not be written to the journal.
+
+    Precondition:  None.
+    Postcondition: A diagnostic is reported and Status::JournalError is
+    returned.
+    -----------------------------------------------------------------------*/
+
+    /******** Subtree Queries ********/
+    template <typename Visit>
+    void forEachPrefixSubtree(int prefix, Visit visit) const;
+    /*----------------------------------------------------------------------
+    Visits the subtrees holding the accounts whose number starts with
+    prefix.
+
+    Precondition:  The tree is held at least shared.
+    Postcondition: visit(node) was called, in chart order, for each
+    subtree root whose number starts with prefix and whose parent's does
+    not; together the subtrees hold exactly the matching accounts, and
+    lazy balances were settled first. Pending roll-ups are left alone;
+    read balances through liveBalance. The roots are found through the
+    account index and the children of the deepest account that is a
+    proper prefix of prefix, so the rest of the chart is not walked.
+    -----------------------------------------------------------------------*/
+
+    template <typename Visit>
+    static void walkSubtree(nodePtr top, Visit visit);
+    /*----------------------------------------------------------------------
+    Visits a subtree in chart order through the parent links.
+
+    Precondition:  top is a node of this tree.
+    Postcondition: visit(node) was called for top and every node below
+    it. Nothing is allocated, unlike traverse.
+    -----------------------------------------------------------------------*/
+
+    TransactionSplit splitAccount(nodePtr node, int firstId, int lastId) const;
+    /*----------------------------------------------------------------------
+    Splits one account's own transactions into debits and credits.
+
+    Precondition:  The tree is held at least shared; the calling thread
+    holds no account lock. The account lock is taken inside.
+    Postcondition: Returns the counts and sums of the account's
+    transactions with IDs in [firstId, lastId], found by binary search of
+    its ID column and one pass over the matching range.
+    -----------------------------------------------------------------------*/
+
+    /******** Export Engine ********/
+    template <typename Visit>
+    void traverse(nodePtr start, int depth, bool withSiblings, Visit visit) const;
+    /*----------------------------------------------------------------------
+    Visits nodes in report order (a node, its subtree, then its next
+    sibling) using an explicit stack, so sibling count does not affect
+    call depth.
+
+    Precondition:  start is nullptr or a node of this tree.
+    Postcondition: visit(node, depth) is called for start and its subtree,
+    and also for the siblings that follow start if withSiblings is true.
+    -----------------------------------------------------------------------*/
+
+    unsigned reportThreads;   // Threads used to render whole-tree reports (0 = one per core)
+
+    unsigned reportThreadCount() const;
+    /*----------------------------------------------------------------------
+    Resolves the report thread setting.
+
+    Precondition:  None.
+    Postcondition: Returns reportThreads, or the number of hardware cores
+    (at least 1) if it is 0.
+    -----------------------------------------------------------------------*/
+
+    template <typename Job>
+    static void runParallel(size_t jobCount, unsigned threadCount, Job job);
+    /*----------------------------------------------------------------------
+    Runs job(i) for every i below jobCount on a pool of threads.
+
+    Precondition:  Jobs may run in any order and at the same time.
+    Postcondition: Every job has finished. Threads take the next job
+    index as they become free. With one thread, the jobs run on the
+    calling thread in order.
+    -----------------------------------------------------------------------*/
+
+    size_t exportReports(vector<nodePtr> &requested) const;
+    /*----------------------------------------------------------------------
+    Body of exportAccountReports and exportAllAccountReports.
+
+    Precondition:  The tree is held exclusively and its balances are
+    settled. requested holds nodes of this tree.
+    Postcondition: One report file per distinct requested node is written,
+    as by printAccount. Returns the number of files written, after a
+    diagnostic if some could not be.
+    -----------------------------------------------------------------------*/
+
+    template <typename Render>
+    void renderReport(ostream &out, Render render) const;
+    /*----------------------------------------------------------------------
+    Renders every account of the tree in report order.
+
+    Precondition:  The tree is held exclusively and its balances are
+    settled. render(buffer, node, depth) appends one node's text and
+    depends on nothing but that node.
+    Postcondition: The text of every node is written to out in report
+    order. With more than one report thread, each top-level account's
+    line and each of its child subtrees is rendered into its own memory
+    buffer by a pool of workers, and the buffers are written out in order
+    as they complete, so the output is byte-identical to a serial render.
+    -----------------------------------------------------------------------*/
+
+    struct BlockLayout {
+        size_t headerStarts[4];   // Where each '-'-indented header line starts
+        size_t bodyStart;         // Where the space-indented transaction list starts
+    };
+
+    void writeAccount(OutputBuffer &out, nodePtr node, int depth, bool shortDescription,
+                      BlockLayout *layout = nullptr) const;
+    /*----------------------------------------------------------------------
+    Appends one account block of a detailed report.
+
+    Precondition:  node is a node of this tree; layout is nullptr unless
+    out keeps its text in memory.
+    Postcondition: The number, description, balance and transactions of
+    node are appended as by writeAccountBlock. shortDescription selects
+    the trimmed 10-character description used by printAccount.
+    -----------------------------------------------------------------------*/
+
+    template <typename TransactionAt>
+    static void writeAccountBlock(OutputBuffer &out, int depth, int accountNumber, string_view description,
+                                  Money balance, size_t transactionCount, TransactionAt transactionAt,
+                                  BlockLayout *layout = nullptr);
+    /*----------------------------------------------------------------------
+    Appends one account block of a detailed report from its fields, so the
+    tree and ForestSnapshot::print share one layout.
+
+    Precondition:  depth is non-negative, and transactionAt(i) returns the
+    account's i-th transaction for each i below transactionCount. layout
+    is nullptr unless out keeps its text in memory.
+    Postcondition: The number, description, balance and transactions are
+    appended with depth-based indentation, followed by a blank line. If
+    layout is given, it receives the positions in out.view() where the
+    indentation went, so the block can be re-indented without parsing it
+    (a description may itself hold newlines).
+    -----------------------------------------------------------------------*/
+
+    static void writeChartLine(OutputBuffer &out, nodePtr node);
+    /*----------------------------------------------------------------------
+    Appends one "number description balance" line of the chart file.
+
+    Precondition:  node is a node of this tree.
+    Postcondition: The line is appended.
+    -----------------------------------------------------------------------*/
+
+    static void writeTransactions(OutputBuffer &out, const TransactionStore &transactions, int depth);
+    /*----------------------------------------------------------------------
+    Appends a list of transactions, or "No transactions" if it is empty.
+
+    Precondition:  depth is non-negative.
+    Postcondition: The transactions are appended with indentation, as by
+    writeTransactionList.
+    -----------------------------------------------------------------------*/
+
+    template <typename TransactionAt>
+    static void writeTransactionList(OutputBuffer &out, int depth, size_t count, TransactionAt transactionAt);
+    /*----------------------------------------------------------------------
+    Appends count transactions, or "No transactions" if count is 0.
+
+    Precondition:  depth is non-negative, and transactionAt(i) returns a
+    Transaction for each i below count.
+    Postcondition: The transactions are appended in order with indentation.
+    -----------------------------------------------------------------------*/
 
 public:
     /******** Constructors ********/
@@ -56,24 +601,46 @@ public:
     Postcondition: An empty ForestTree is initialized with root set to nullptr.
     -----------------------------------------------------------------------*/
 
+    ~ForestTree() = default;
+    /*----------------------------------------------------------------------
+    Destroys the tree.
+
+    Precondition:  None.
+    Postcondition: Every node is released together with the node pool.
+    -----------------------------------------------------------------------*/
+
+    ForestTree(const ForestTree &) = delete;
+    ForestTree &operator=(const ForestTree &) = delete;
+
+    void clear();
+    /*----------------------------------------------------------------------
+    Removes every account from the tree.
+
+    Precondition:  No node pointer obtained from this tree is used afterwards.
+    Postcondition: The tree is empty. All nodes are destroyed in bulk and
+    the pool's memory is kept for the next build.
+    -----------------------------------------------------------------------*/
+
     /******** Account Management ********/
-    bool addAccount(const Account &acc);
+    Status addAccount(const Account &acc);
     /*----------------------------------------------------------------------
     Adds an Account object to the tree.
 
     Precondition:  acc is a valid Account object.
     Postcondition: The account is inserted into the tree based on its
-    account number. Returns true if successful, otherwise false.
+    account number and Status::Ok is returned. Otherwise the tree is
+    unchanged, a diagnostic is reported and InvalidAccountNumber,
+    ParentMissing, AccountExists or TransactionExists (acc holds an ID
+    another account already uses) is returned.
     -----------------------------------------------------------------------*/
 
-    bool addAccount(int accountNumber, const string description, double balance);
+    Status addAccount(int accountNumber, const string description, Money balance);
     /*----------------------------------------------------------------------
     Creates an Account and adds it to the tree.
 
-    Precondition:  accountNumber is a unique integer, description is non-empty,
-    and balance is a valid double.
-    Postcondition: A new Account is created and added to the tree. Returns true
-    if successful, otherwise false.
+    Precondition:  accountNumber is a unique integer, description is non-empty.
+    Postcondition: A new Account is created and added to the tree. Returns
+    the status of addAccount(const Account&).
     -----------------------------------------------------------------------*/
 
     bool buildTreeFromFile(const string &filePath);
@@ -82,13 +649,83 @@ public:
 
     Precondition:  filePath is a valid file path to an account data file.
     Postcondition: Accounts from the file are added to the ForestTree.
-    Returns true if the operation succeeds, otherwise false.
+    Returns true if the operation succeeds, otherwise false. An unreadable
+    file and every rejected line are reported as diagnostics. The file is
+    memory-mapped and parsed in place; records in account-number order are
+    linked in one pass without searching the tree.
+    -----------------------------------------------------------------------*/
+
+    /******** Balance Mode ********/
+    void setLazyBalances(bool lazy);
+    /*----------------------------------------------------------------------
+    Chooses how ancestor balances follow postings and new accounts.
+
+    Precondition:  None.
+    Postcondition: When lazy is true, writes only mark ancestors dirty and
+    rolled-up balances are recomputed when they are next read (reports,
+    findAccount). When lazy is false, pending totals are settled first and
+    ancestors are updated on every write again.
+    -----------------------------------------------------------------------*/
+
+    bool usesLazyBalances() const;
+    /*----------------------------------------------------------------------
+    Reports the balance mode.
+
+    Precondition:  None.
+    Postcondition: Returns true if lazy roll-up is enabled.
+    -----------------------------------------------------------------------*/
+
+    /******** Report Mode ********/
+    void setReportThreads(unsigned threadCount);
+    /*----------------------------------------------------------------------
+    Chooses how many threads render whole-tree reports.
+
+    Precondition:  None.
+    Postcondition: operator<< and printTreeIntoFile render with threadCount
+    threads, or one per hardware core if threadCount is 0. 1 (the default)
+    renders serially. The output is the same in every case.
+    -----------------------------------------------------------------------*/
+
+    unsigned getReportThreads() const;
+    /*----------------------------------------------------------------------
+    Reports the report thread setting.
+
+    Precondition:  None.
+    Postcondition: Returns the value given to setReportThreads.
+    -----------------------------------------------------------------------*/
+
+    /******** Concurrency Mode ********/
+    void setConcurrent(bool concurrent);
+    /*----------------------------------------------------------------------
+    Turns synchronization of the public operations on or off.
+
+    Precondition:  No other thread is using the tree.
+    Postcondition: In concurrent mode, the tree may be used from several
+    threads. Postings and single-account reads hold the structure shared
+    and lock only the account they touch, through striped locks.
+    Ancestor roll-ups take no lock at all. They go into per-thread
+    sharded counters on the top two levels, where every posting lands,
+    and into one atomic counter per node deeper down. Readers add the
+    pending amount to the balance. Reports fold it in first while
+    holding the structure exclusively, as do adding accounts, loading,
+    clearing and replaying. Methods that take a node pointer are not
+    synchronized. Lazy balances are not used while concurrent.
+    -----------------------------------------------------------------------*/
+
+    bool isConcurrent() const;
+    /*----------------------------------------------------------------------
+    Checks whether the tree synchronizes its public operations.
+
+    Precondition:  None.
+    Postcondition: Returns true in concurrent mode.
     -----------------------------------------------------------------------*/
 
     /******** Searching ********/
     vector<nodePtr> searchAccountWithTracking(int accountNumber, vector<Account*> &tracking) const;
     /*----------------------------------------------------------------------
-    Searches for an account by its account number with tracking.
+    Searches for an account by its account number with tracking. This walks
+    the child/sibling links and is used to find insertion positions; plain
+    lookups go through the account index instead.
 
     Precondition:  accountNumber is a valid integer. The tracking vector
     must be empty to store the search path.
@@ -105,17 +742,52 @@ public:
     nodes for the matching account.
     -----------------------------------------------------------------------*/
 
-    void findAccount(int accountNumber) const;
+    bool getAccountBalance(int accountNumber, Money &balance) const;
+    /*----------------------------------------------------------------------
+    Reads an account's rolled-up balance.
+
+    Precondition:  None.
+    Postcondition: Returns true and sets balance if the account exists;
+    otherwise returns false. Nothing is printed.
+    -----------------------------------------------------------------------*/
+
+    Status getBalanceAsOf(int accountNumber, int date, Money &balance) const;
+    /*----------------------------------------------------------------------
+    Reads an account's rolled-up balance at the end of a day.
+
+    Precondition:  date is a yyyymmdd date.
+    Postcondition: Sets balance and returns Status::Ok if the account
+    exists. Postings dated after date are left out; opening balances and
+    undated postings count as effective before every date. Answered from
+    the balance histories in O(log d) for d days covered, without
+    replaying transactions. Otherwise reports a diagnostic and returns
+    Status::InvalidDate or Status::AccountNotFound.
+    -----------------------------------------------------------------------*/
+
+    Status getBalanceChange(int accountNumber, int fromDate, int toDate, Money &change) const;
+    /*----------------------------------------------------------------------
+    Reads the net change of an account's rolled-up balance over a period.
+
+    Precondition:  fromDate and toDate are yyyymmdd dates.
+    Postcondition: Sets change to the signed total of the postings dated
+    from fromDate to toDate, both included, in the account and its
+    subaccounts, and returns Status::Ok (change is 0 if fromDate >
+    toDate). Runs in O(log d). Otherwise reports a diagnostic and returns
+    Status::InvalidDate or Status::AccountNotFound.
+    -----------------------------------------------------------------------*/
+
+    Status findAccount(int accountNumber, ostream &out) const;
     /*----------------------------------------------------------------------
     Displays details of an account by its account number.
 
     Precondition:  accountNumber is a valid integer.
-    Postcondition: Prints account details to the console if found, or an
-    error message if not found.
+    Postcondition: Writes the account details to out and returns
+    Status::Ok if found; otherwise reports a diagnostic and returns
+    Status::AccountNotFound.
     -----------------------------------------------------------------------*/
 
     /******** Transaction Management ********/
-    void addAcountTransaction(int accountNumber, const Transaction &transaction);
+    Status addAcountTransaction(int accountNumber, const Transaction &transaction);
     /*----------------------------------------------------------------------
     Adds a transaction to a specified account.
 
@@ -123,16 +795,99 @@ public:
     valid Transaction object.
     Postcondition: The transaction is added to the account. If the account is
     part of a tracked path, the balances of related accounts are updated.
+    Returns Status::Ok, or AccountNotFound, TransactionExists (if any
+    account already holds the ID) or JournalError after reporting a
+    diagnostic. With a journal attached the record is written first, so
+    on JournalError the tree is unchanged and the posting may be retried.
     -----------------------------------------------------------------------*/
 
-    void removeAccountTransaction(int accountNumber, int transactionID);
+    Status removeAccountTransaction(int accountNumber, int transactionID);
     /*----------------------------------------------------------------------
     Removes a transaction from a specified account.
 
     Precondition:  accountNumber and transactionID are valid integers.
     Postcondition: The specified transaction is removed from the account.
     If the account is part of a tracked path, the balances of related
-    accounts are updated.
+    accounts are updated. Returns Status::Ok, or AccountNotFound,
+    TransactionNotFound or JournalError after reporting a diagnostic. As
+    with addAcountTransaction, the tree is unchanged on JournalError.
+    -----------------------------------------------------------------------*/
+
+    Status removeTransaction(int transactionID);
+    /*----------------------------------------------------------------------
+    Removes a transaction without knowing its account.
+
+    Precondition:  None.
+    Postcondition: The account holding transactionID is found in the
+    transaction index in O(1) average time, and the transaction is removed
+    from it as by removeAccountTransaction. Returns TransactionNotFound
+    after reporting a diagnostic if no account holds the ID.
+    -----------------------------------------------------------------------*/
+
+    Status findTransaction(int transactionID, int &accountNumber, Transaction &found) const;
+    /*----------------------------------------------------------------------
+    Finds a transaction without knowing its account.
+
+    Precondition:  None.
+    Postcondition: If an account holds transactionID, its number is copied
+    into accountNumber, the transaction into found, and Status::Ok is
+    returned, in O(1) average time. Otherwise reports a diagnostic and
+    returns TransactionNotFound.
+    -----------------------------------------------------------------------*/
+
+    vector<PostStatus> postBatch(const vector<pair<int, Transaction>> &postings);
+    /*----------------------------------------------------------------------
+    Adds a batch of (account number, transaction) postings.
+
+    Precondition:  None.
+    Postcondition: Postings are applied in order. Each posted account's
+    balance is updated as with addAcountTransaction, but the account locks
+    are taken once for the whole batch and each ancestor receives one
+    combined delta per posted account instead of one per posting. With a
+    journal attached the batch is committed with one sync. A posting the
+    journal refuses to queue, and every posting of a commit that fails and
+    is cut off the journal, is rolled back and reported as JournalError
+    after a diagnostic. If the journal fails and may hold part of the
+    batch, the batch stays applied after a diagnostic. Returns one status
+    per posting; nothing else is printed.
+    -----------------------------------------------------------------------*/
+
+    /******** Journaling ********/
+    void setJournal(Journal *journal);
+    /*----------------------------------------------------------------------
+    Attaches a journal that records postings from now on.
+
+    Precondition:  journal is nullptr or an open Journal that outlives its
+    use by this tree.
+    Postcondition: Every successful addAcountTransaction and
+    removeAccountTransaction is made durable in the journal before the
+    call returns; postBatch commits its whole batch with one sync.
+    nullptr detaches the journal.
+    -----------------------------------------------------------------------*/
+
+    bool replayJournal(const string &filePath);
+    /*----------------------------------------------------------------------
+    Re-applies the postings recorded in a journal file.
+
+    Precondition:  The tree holds the state the journal was started from,
+    normally the snapshot saved at the last checkpoint.
+    Postcondition: Every valid record is applied in order, nothing is
+    printed and nothing is journaled again. Ancestor balances receive one
+    combined delta per account, and histories are re-sorted lazily on
+    first read. Records for missing accounts, duplicate adds and removals
+    of absent IDs are skipped. Returns false if the file is not a journal.
+    -----------------------------------------------------------------------*/
+
+    bool checkpoint(const string &snapshotPath);
+    /*----------------------------------------------------------------------
+    Saves a snapshot and empties the attached journal.
+
+    Precondition:  None.
+    Postcondition: The snapshot holds the whole tree and is durable, as
+    with saveSnapshot. Only then, if a journal is attached, is the journal
+    reset and synced, so a crash at any point leaves either the old
+    snapshot with the whole journal or the new snapshot. Returns true if
+    both steps succeeded.
     -----------------------------------------------------------------------*/
 
     /******** Printing ********/
@@ -142,12 +897,14 @@ public:
 
     Precondition:  node is a valid pointer, depth is non-negative, and
     out is an open output stream.
-    Postcondition: The tree structure is printed to the output stream.
+    Postcondition: The tree structure (node, its subtree and its following
+    siblings) is printed to the output stream.
     -----------------------------------------------------------------------*/
 
     void printAccountRecursive(nodePtr node, int depth, ostream &out) const;
     /*----------------------------------------------------------------------
-    Recursively prints account details starting from a given node.
+    Prints account details starting from a given node (siblings of node
+    are included only when depth is not 0).
 
     Precondition:  node is a valid pointer, depth is non-negative, and
     out is an open output stream.
@@ -155,13 +912,39 @@ public:
     proper indentation.
     -----------------------------------------------------------------------*/
 
-    void printAccount(int accountNumber) const;
+    Status printAccount(int accountNumber) const;
     /*----------------------------------------------------------------------
     Prints the details of a specific account to a file.
 
     Precondition:  accountNumber is a valid integer.
     Postcondition: Account details are written to a file in a predefined
-    directory. If the account is not found, an error message is displayed.
+    directory and Status::Ok is returned. Otherwise a diagnostic is
+    reported and AccountNotFound or FileError is returned.
+    -----------------------------------------------------------------------*/
+
+    size_t exportAccountReports(const vector<int> &accountNumbers) const;
+    /*----------------------------------------------------------------------
+    Prints the detailed reports of several accounts to files at once.
+
+    Precondition:  None.
+    Postcondition: For each existing account in accountNumbers, the file
+    printAccount would write is written, with identical contents. The
+    output directory is checked once. Every account that appears in one
+    or more of the reports is rendered once, in one traversal, and each
+    report is assembled from those renderings at its own indentation.
+    Files are written concurrently by the report threads (see
+    setReportThreads). Files that cannot be written are reported in one
+    FileError diagnostic. Returns the number of files written; duplicates
+    are skipped, and missing accounts are skipped after a diagnostic.
+    -----------------------------------------------------------------------*/
+
+    Status exportAllAccountReports() const;
+    /*----------------------------------------------------------------------
+    Prints the detailed report of every account to a file.
+
+    Precondition:  None.
+    Postcondition: As exportAccountReports for every account in the tree.
+    Returns Status::Ok if every file was written, otherwise FileError.
     -----------------------------------------------------------------------*/
 
     bool printTreeIntoFile(const string &fileName);
@@ -170,27 +953,133 @@ public:
 
     Precondition:  fileName is a valid file path.
     Postcondition: The tree structure is written to the specified file.
-    Returns true if successful, otherwise false.
+    Returns true if successful, otherwise false; a file that cannot be
+    opened is reported as a diagnostic.
     -----------------------------------------------------------------------*/
 
     void printTreeRecursive(nodePtr node, ostream &out);
     /*----------------------------------------------------------------------
-    Recursively writes the tree structure starting from a given node.
+    Writes the tree structure (number, description, balance per line)
+    starting from a given node.
 
     Precondition:  node is a valid pointer, and out is an open output stream.
-    Postcondition: The tree structure is recursively written to the stream.
+    Postcondition: The tree structure is written to the stream.
     -----------------------------------------------------------------------*/
 
-    void printTransactions(const vector<Transaction> &transactions, int depth, ostream &out) const;
+    void printTransactions(const TransactionStore &transactions, int depth, ostream &out) const;
     /*----------------------------------------------------------------------
     Prints a list of transactions with specified indentation.
 
-    Precondition:  transactions is a vector of Transaction objects, depth is
+    Precondition:  transactions is an account's transaction store, depth is
     non-negative, and out is an open output stream.
     Postcondition: Transactions are printed to the output stream with the
     specified indentation.
     -----------------------------------------------------------------------*/
 
+    /******** Snapshots ********/
+    ForestSnapshot snapshot() const;
+    /*----------------------------------------------------------------------
+    Builds a flattened, read-only copy of the tree.
+
+    Precondition:  None.
+    Postcondition: Returns a ForestSnapshot of the current accounts,
+    balances and transactions (see ForestSnapshot.h). The tree is held
+    exclusively while it is copied, so concurrent postings wait.
+    -----------------------------------------------------------------------*/
+
+    bool saveSnapshot(const string &filePath) const;
+    /*----------------------------------------------------------------------
+    Writes the whole tree to a binary snapshot file.
+
+    Precondition:  filePath is a writable path.
+    Postcondition: The file holds every account with its rolled-up and own
+    balances and every transaction (see SnapshotFormat.h). The snapshot is
+    written and synced under filePath + ".tmp", renamed over filePath and
+    the directory synced, so an existing file is replaced whole or not at
+    all. Returns true if every step succeeded.
+    -----------------------------------------------------------------------*/
+
+    Status loadSnapshot(const string &filePath);
+    /*----------------------------------------------------------------------
+    Replaces the tree with the contents of a binary snapshot file.
+
+    Precondition:  No node pointer obtained from this tree is used afterwards.
+    Postcondition: If the file is a valid snapshot of this version with a
+    matching checksum, no repeated account number and no repeated
+    transaction ID, the tree holds exactly the saved accounts, balances and
+    transactions and Status::Ok is returned. The file is memory-mapped and
+    the tree is linked directly from the preorder records, without
+    searching or replaying postings. Otherwise the tree is unchanged, a
+    diagnostic is reported and the cause is returned: FileError if the
+    file cannot be opened, VersionMismatch, ChecksumMismatch, AccountExists
+    or TransactionExists for a repeated number or ID, and InvalidFormat
+    for any other damage.
+    -----------------------------------------------------------------------*/
+
+    /******** Subtree Queries ********/
+    bool summarizeAccounts(int prefix, BalanceSummary &summary) const;
+    /*----------------------------------------------------------------------
+    Summarizes the balances of every account whose number starts with
+    prefix (e.g. 40 covers 40, 401 and 4011, or 401 and 402 if there is
+    no account 40).
+
+    Precondition:  None.
+    Postcondition: Returns false if no account matches. Otherwise sets
+    the number of matching accounts, their combined balance and the
+    lowest and highest single balances with their accounts, and returns
+    true. The answer is read from the live tree: the combined balance
+    comes from the maintained subtree balances, and only the matching
+    subtrees are walked. In concurrent mode the walk shares the tree and
+    locks one account at a time, so postings go on meanwhile; each
+    balance is current when read.
+    -----------------------------------------------------------------------*/
+
+    vector<AccountBalance> topAccounts(int prefix, size_t count, bool largest = true) const;
+    /*----------------------------------------------------------------------
+    Finds the accounts under prefix with the highest balances, or the
+    lowest if largest is false.
+
+    Precondition:  None.
+    Postcondition: Returns up to count accounts, best first; ties are in
+    chart order. Runs in O(m log count) for m matching accounts.
+    -----------------------------------------------------------------------*/
+
+    TransactionSplit splitTransactions(int prefix, int firstId, int lastId) const;
+    /*----------------------------------------------------------------------
+    Totals the debits and credits of the accounts under prefix.
+
+    Precondition:  None.
+    Postcondition: Returns the counts and sums of the debits and credits
+    with IDs in [firstId, lastId] held by the matching accounts
+    themselves (not rolled up twice); accountNumber is 0. Each account's
+    ID range is found by binary search, so the cost is in the matching
+    accounts and transactions.
+    -----------------------------------------------------------------------*/
+
+    vector<TransactionSplit> splitTransactionsByAccount(int prefix, int firstId, int lastId) const;
+    /*----------------------------------------------------------------------
+    Splits the debits and credits of each account under prefix.
+
+    Precondition:  None.
+    Postcondition: Returns, in chart order, the split of every matching
+    account with a transaction ID in [firstId, lastId].
+    -----------------------------------------------------------------------*/
+
+    /******** Auditing ********/
+    AuditReport auditBalances(AuditKernel kernel = AuditKernel::Vector) const;
+    /*----------------------------------------------------------------------
+    Recomputes every balance from the transactions and compares it with
+    the maintained one.
+
+    Precondition:  None.
+    Postcondition: Pending roll-ups are folded and lazy balances settled
+    first. Each account's opening balance plus the signed sum of its own
+    transactions (summed by kernel) is compared with its own balance, and
+    that plus the recomputed totals of its subaccounts, rolled up
+    bottom-up, with its balance. Returns the counts and every
+    disagreement, in chart order. Nothing is printed.
+    -----------------------------------------------------------------------*/
+
     /******** Stream Operators ********/
     friend ostream& operator<<(ostream &out, const ForestTree &tree);
     /*----------------------------------------------------------------------
@@ -199,4 +1088,46 @@ public:
     Precondition:  The ostream 'out' is open.
     Postcondition: The entire tree structure is written to the stream.
     -----------------------------------------------------------------------*/
-};
\ No newline at end of file
+};
+
+template <typename TransactionAt>
+void ForestTree::writeTransactionList(OutputBuffer & out, int depth, size_t count, TransactionAt transactionAt) {
+    if (count == 0) {
+        out.fill(' ', depth * 2);
+        out.write("No transactions\n");
+    }
+    for (size_t i = 0; i < count; i++) {
+        transactionAt(i).printWithIndentation(depth, out);
+    }
+}
+
+template <typename TransactionAt>
+void ForestTree::writeAccountBlock(OutputBuffer & out, int depth, int accountNumber, string_view description,
+                                   Money balance, size_t transactionCount, TransactionAt transactionAt,
+                                   BlockLayout * layout) {
+    auto headerLine = [&](int line) {
+        if (layout != nullptr) {
+            layout->headerStarts[line] = out.view().size();
+        }
+        out.fill('-', depth * 2);
+    };
+    headerLine(0);
+    out.write("Account Number: ");
+    out.writeInt(accountNumber);
+    out.put('\n');
+    headerLine(1);
+    out.write("Description: ");
+    out.write(description);
+    out.put('\n');
+    headerLine(2);
+    out.write("Balance: ");
+    out.writeMoney(balance);
+    out.put('\n');
+    headerLine(3);
+    out.write("Transactions:\n");
+    if (layout != nullptr) {
+        layout->bodyStart = out.view().size();
+    }
+    writeTransactionList(out, depth + 1, transactionCount, transactionAt);
+    out.put('\n');
+}
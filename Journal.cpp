@@ -0,0 +1,237 @@
+#include "Journal.h"
+#include "SnapshotFormat.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define JOURNAL_USE_FSYNC 1
+#endif
+
+// Checksum of a record's fields, excluding the checksum itself
+static uint64_t recordChecksum(const JournalRecord & record) {
+    return snapshotChecksum(reinterpret_cast<const char *>(&record),
+                            offsetof(JournalRecord, checksum));
+}
+
+Journal::Journal() : file(nullptr), committedBytes(0), failed(false) {}
+
+Journal::~Journal() {
+    close();
+}
+
+bool Journal::open(const string & filePath) {
+    close();
+    lock_guard<mutex> guard(lock);
+
+    error_code error;
+    uintmax_t size = filesystem::file_size(filePath, error);
+    if (error || size == 0) {
+        // New journal: write the header and make it durable
+        FILE * created = fopen(filePath.c_str(), "wb");
+        if (created == nullptr) {
+            return false;
+        }
+        JournalHeader header = {};
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.byteOrderMark = SNAPSHOT_BYTE_ORDER_MARK;
+        bool written = fwrite(&header, sizeof(header), 1, created) == 1 && fflush(created) == 0;
+#ifdef JOURNAL_USE_FSYNC
+        written = written && fsync(fileno(created)) == 0;
+#endif
+        fclose(created);
+        if (!written) {
+            return false;
+        }
+        size = sizeof(JournalHeader);
+    } else {
+        // Existing journal: keep the valid records, cut off a torn tail
+        MappedFile existing;
+        const JournalRecord * records;
+        size_t count;
+        if (!existing.open(filePath) || !readRecords(existing, records, count)) {
+            return false;
+        }
+        uintmax_t validSize = sizeof(JournalHeader) + count * sizeof(JournalRecord);
+        existing.close();
+        if (validSize != size) {
+            filesystem::resize_file(filePath, validSize, error);
+            if (error) {
+                return false;
+            }
+        }
+        size = validSize;
+    }
+
+    file = fopen(filePath.c_str(), "ab");
+    if (file == nullptr) {
+        return false;
+    }
+    path = filePath;
+    committedBytes = size;
+    failed = false;
+    return true;
+}
+
+bool Journal::close() {
+    lock_guard<mutex> guard(lock);
+    auto group = groups.find(this_thread::get_id());
+    bool committed = group == groups.end() || commitPending(group->second);
+    groups.clear();
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+    return committed;
+}
+
+bool Journal::isOpen() const {
+    return file != nullptr;
+}
+
+bool Journal::hasFailed() const {
+    return failed;
+}
+
+bool Journal::append(const JournalRecord & record) {
+    lock_guard<mutex> guard(lock);
+    if (file == nullptr) {
+        return false;
+    }
+    thread::id caller = this_thread::get_id();
+    Group & group = groups[caller];
+    group.pending.push_back(record);
+    group.pending.back().checksum = recordChecksum(group.pending.back());
+    if (group.depth > 0) {
+        return true;
+    }
+    bool committed = commitPending(group);
+    groups.erase(caller);
+    return committed;
+}
+
+bool Journal::recordAdd(int accountNumber, const Transaction & transaction) {
+    JournalRecord record = {};
+    record.kind = JOURNAL_ADD;
+    record.accountNumber = accountNumber;
+    record.transactionID = transaction.getId();
+    record.type = transaction.getType();
+    record.amountCents = transaction.getAmount().getCents();
+    record.date = transaction.getDate();
+    return append(record);
+}
+
+bool Journal::recordRemove(int accountNumber, int transactionID) {
+    JournalRecord record = {};
+    record.kind = JOURNAL_REMOVE;
+    record.accountNumber = accountNumber;
+    record.transactionID = transactionID;
+    return append(record);
+}
+
+void Journal::beginGroup() {
+    lock_guard<mutex> guard(lock);
+    groups[this_thread::get_id()].depth++;
+}
+
+bool Journal::endGroup() {
+    lock_guard<mutex> guard(lock);
+    auto group = groups.find(this_thread::get_id());
+    if (group == groups.end()) {
+        return true;
+    }
+    if (--group->second.depth > 0) {
+        return true;
+    }
+    bool committed = commitPending(group->second);
+    groups.erase(group);
+    return committed;
+}
+
+bool Journal::commit() {
+    lock_guard<mutex> guard(lock);
+    auto group = groups.find(this_thread::get_id());
+    return group == groups.end() || commitPending(group->second);
+}
+
+bool Journal::commitPending(Group & group) {
+    if (group.pending.empty()) {
+        return true;
+    }
+    vector<JournalRecord> records;
+    records.swap(group.pending);
+    if (file == nullptr) {
+        return false;
+    }
+    size_t count = records.size();
+    bool written = fwrite(records.data(), sizeof(JournalRecord), count, file) == count
+                   && fflush(file) == 0;
+#ifdef JOURNAL_USE_FSYNC
+    written = written && fsync(fileno(file)) == 0;
+#endif
+    if (written) {
+        committedBytes += count * sizeof(JournalRecord);
+        return true;
+    }
+
+    // Cut the torn commit off, so that replay does not stop at it and lose
+    // the records committed after it
+    fclose(file);
+    error_code error;
+    filesystem::resize_file(path, committedBytes, error);
+    file = error ? nullptr : fopen(path.c_str(), "ab");
+#ifdef JOURNAL_USE_FSYNC
+    if (file != nullptr && fsync(fileno(file)) != 0) {
+        fclose(file);
+        file = nullptr;
+    }
+#endif
+    failed = file == nullptr;
+    return false;
+}
+
+bool Journal::reset() {
+    lock_guard<mutex> guard(lock);
+    if (file == nullptr) {
+        return false;
+    }
+    for (auto & group : groups) {
+        group.second.pending.clear();
+    }
+    fflush(file);
+    error_code error;
+    filesystem::resize_file(path, sizeof(JournalHeader), error);
+    if (error) {
+        return false;
+    }
+    committedBytes = sizeof(JournalHeader);
+#ifdef JOURNAL_USE_FSYNC
+    return fsync(fileno(file)) == 0;
+#else
+    return true;
+#endif
+}
+
+bool Journal::readRecords(const MappedFile & file, const JournalRecord *& records, size_t & count) {
+    records = nullptr;
+    count = 0;
+    if (file.size() < sizeof(JournalHeader)) {
+        return false;
+    }
+    JournalHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION ||
+        header.byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK) {
+        return false;
+    }
+
+    records = reinterpret_cast<const JournalRecord *>(file.data() + sizeof(header));
+    size_t available = (file.size() - sizeof(header)) / sizeof(JournalRecord);
+    while (count < available && records[count].checksum == recordChecksum(records[count])) {
+        count++;
+    }
+    return true;
+}
@@ -0,0 +1,234 @@
+/*-- Journal.h ---------------------------------------------------------------
+
+  This header file defines the Journal class, an append-only write-ahead
+  log of transaction postings. Together with a binary snapshot it lets a
+  ForestTree be recovered after the program exits: load the last snapshot,
+  then replay the journal written since (see ForestTree::replayJournal).
+
+  A journal file is a JournalHeader followed by fixed-size JournalRecords.
+  Each record carries its own checksum, so a record torn by a crash is
+  detected and dropped together with everything after it.
+
+  All operations may be called from several threads. Pending records and
+  groups belong to the thread that queued them, and a commit writes only
+  the calling thread's records, so nothing of a group is durable before
+  its own endGroup(). A commit that fails is cut back off the file, so the
+  records committed after it stay readable; if that is impossible the
+  journal fails and rejects every record until it is reopened.
+
+  Basic operations include:
+     - Opening: Create a journal or reopen an existing one for appending
+     - Recording: Append add/remove records
+     - Group Commit: Write and sync a whole group of records at once
+     - Reset: Empty the journal after a checkpoint
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "Transaction.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+/******** On-disk Layout ********/
+static const char JOURNAL_MAGIC[8] = {'F', 'T', 'J', 'R', 'N', 'L', '\0', '\0'};
+static const uint32_t JOURNAL_VERSION = 2;    // 2: adds carry a date
+
+struct JournalHeader {
+    char magic[8];              // JOURNAL_MAGIC
+    uint32_t version;           // JOURNAL_VERSION
+    uint32_t byteOrderMark;     // SNAPSHOT_BYTE_ORDER_MARK as written by the journal
+};
+
+enum JournalRecordKind : int32_t {
+    JOURNAL_ADD = 1,            // A transaction was added to an account
+    JOURNAL_REMOVE = 2          // A transaction was removed from an account
+};
+
+struct JournalRecord {
+    int32_t kind;               // JournalRecordKind
+    int32_t accountNumber;      // Account the posting belongs to
+    int32_t transactionID;      // Transaction ID
+    int32_t type;               // 'D' or 'C' (adds only)
+    int64_t amountCents;        // Non-negative amount (adds only)
+    int32_t date;               // Posting date as yyyymmdd, or 0 if undated (adds only)
+    int32_t reserved;           // Zero
+    uint64_t checksum;          // Checksum of the fields above
+};
+
+class Journal {
+private:
+    /******** Data Members ********/
+    struct Group {
+        int depth = 0;                  // Open beginGroup() calls
+        vector<JournalRecord> pending;  // Records not yet written
+    };
+
+    string path;                // Path of the open journal
+    FILE *file;                 // Append handle, nullptr while closed
+    uint64_t committedBytes;    // Length of the file up to the last durable record
+    bool failed;                // A failed commit could not be cut off the file
+    unordered_map<thread::id, Group> groups;  // Pending records and groups per thread
+    mutex lock;                 // Guards every member above
+
+    /******** Private Member Functions ********/
+    bool append(const JournalRecord &record);
+    /*----------------------------------------------------------------------
+    Queue a record and commit it unless the calling thread has a group open.
+
+    Precondition:  None.
+    Postcondition: The record is pending or durable. Returns false without
+    queuing it if the journal is closed or failed, or if the commit failed.
+    -----------------------------------------------------------------------*/
+
+    bool commitPending(Group &group);
+    /*----------------------------------------------------------------------
+    Write and sync one thread's pending records; the caller holds lock.
+
+    Precondition:  None.
+    Postcondition: group has no pending records. On success they are
+    durable and committedBytes covers them. On failure the file is cut
+    back to committedBytes and reopened, or, if that fails, closed with
+    failed set. Returns true on success.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    Journal();
+    /*----------------------------------------------------------------------
+    Construct a closed journal.
+
+    Precondition:  None.
+    Postcondition: isOpen() returns false.
+    -----------------------------------------------------------------------*/
+
+    ~Journal();
+    /*----------------------------------------------------------------------
+    Commit pending records and close the journal.
+
+    Precondition:  None.
+    Postcondition: The file is closed.
+    -----------------------------------------------------------------------*/
+
+    Journal(const Journal &) = delete;
+    Journal &operator=(const Journal &) = delete;
+
+    /******** Opening and Closing ********/
+    bool open(const string &filePath);
+    /*----------------------------------------------------------------------
+    Open a journal for appending, creating it if needed.
+
+    Precondition:  None.
+    Postcondition: Returns true if the file is a journal (or was created as
+    an empty one); a failed journal is usable again. A torn record at the end of an existing journal is cut
+    off so new records follow the last valid one. Returns false and leaves
+    the file alone if it is not a journal of this version.
+    -----------------------------------------------------------------------*/
+
+    bool close();
+    /*----------------------------------------------------------------------
+    Commit the calling thread's pending records and close the journal.
+
+    Precondition:  None.
+    Postcondition: isOpen() returns false. Records other threads still
+    hold in open groups are dropped. Returns false if the final commit
+    failed.
+    -----------------------------------------------------------------------*/
+
+    bool isOpen() const;
+    /*----------------------------------------------------------------------
+    Check whether the journal is open.
+
+    Precondition:  None.
+    Postcondition: Returns true after a successful open() until close()
+    or until the journal fails.
+    -----------------------------------------------------------------------*/
+
+    bool hasFailed() const;
+    /*----------------------------------------------------------------------
+    Check whether a failed commit was left in the file.
+
+    Precondition:  None.
+    Postcondition: Returns true if a commit failed and could not be cut
+    off; the file may then hold some of that commit's records, and every
+    record is rejected until the journal is reopened.
+    -----------------------------------------------------------------------*/
+
+    /******** Recording ********/
+    bool recordAdd(int accountNumber, const Transaction &transaction);
+    /*----------------------------------------------------------------------
+    Record that a transaction was added to an account.
+
+    Precondition:  None.
+    Postcondition: The record is durable on return unless a group is open.
+    Returns false if the journal is closed or failed or writing failed.
+    -----------------------------------------------------------------------*/
+
+    bool recordRemove(int accountNumber, int transactionID);
+    /*----------------------------------------------------------------------
+    Record that a transaction was removed from an account.
+
+    Precondition:  None.
+    Postcondition: The record is durable on return unless a group is open.
+    Returns false if the journal is closed or failed or writing failed.
+    -----------------------------------------------------------------------*/
+
+    /******** Group Commit ********/
+    void beginGroup();
+    /*----------------------------------------------------------------------
+    Start collecting records instead of committing each one.
+
+    Precondition:  None.
+    Postcondition: The calling thread's records stay pending until its
+    matching endGroup(). Groups nest; only the outermost endGroup() commits.
+    -----------------------------------------------------------------------*/
+
+    bool endGroup();
+    /*----------------------------------------------------------------------
+    Close a group opened by beginGroup().
+
+    Precondition:  beginGroup() was called.
+    Postcondition: When the outermost group closes, the calling thread's
+    pending records are written with a single write and a single sync.
+    Returns false if that commit failed; unless hasFailed(), none of the
+    records are then in the file.
+    -----------------------------------------------------------------------*/
+
+    bool commit();
+    /*----------------------------------------------------------------------
+    Write and sync the calling thread's pending records now.
+
+    Precondition:  None.
+    Postcondition: As the outermost endGroup(), without closing a group.
+    -----------------------------------------------------------------------*/
+
+    bool reset();
+    /*----------------------------------------------------------------------
+    Empty the journal, normally right after a snapshot has been saved.
+
+    Precondition:  The journal is open.
+    Postcondition: The file holds only its header, durably; the pending
+    records of every thread are dropped. Returns false if the file could not be truncated
+    or synced.
+    -----------------------------------------------------------------------*/
+
+    /******** Reading ********/
+    static bool readRecords(const MappedFile &file, const JournalRecord *&records, size_t &count);
+    /*----------------------------------------------------------------------
+    Locate the valid records of a mapped journal file.
+
+    Precondition:  file is open.
+    Postcondition: Returns false if the file is not a journal of this
+    version. Otherwise records points at the first record (aligned to
+    JournalRecord when the mapping is) and count is the number of
+    leading records whose checksums match.
+    -----------------------------------------------------------------------*/
+};
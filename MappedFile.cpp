@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_USE_MMAP 1
+#endif
+
+MappedFile::MappedFile()
+ : contents(nullptr), length(0), mapped(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const string & filePath) {
+    close();
+
+#ifdef MAPPED_FILE_USE_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = info.st_size;
+    if (length == 0) {
+        // Nothing to map; expose an empty buffer
+        ::close(fd);
+        contents = buffer.data();
+        return true;
+    }
+    void * address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address != MAP_FAILED) {
+        madvise(address, length, MADV_SEQUENTIAL);
+        contents = static_cast<const char *>(address);
+        mapped = true;
+        return true;
+    }
+    length = 0;
+#endif
+
+    // Fall back to reading the whole file
+    ifstream file(filePath, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    ostringstream data;
+    data << file.rdbuf();
+    buffer = data.str();
+    contents = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef MAPPED_FILE_USE_MMAP
+    if (mapped) {
+        munmap(const_cast<char *>(contents), length);
+    }
+#endif
+    contents = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
+
+bool MappedFile::isOpen() const {
+    return contents != nullptr;
+}
+
+const char * MappedFile::data() const {
+    return contents;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,92 @@
+/*-- MappedFile.h ------------------------------------------------------------
+
+  This header file defines the MappedFile class, which gives read-only
+  access to the whole contents of a file as one contiguous block of memory.
+
+  Basic operations include:
+     - Opening: Map a file into memory (or read it when mapping is
+       unavailable)
+     - Access: Pointer to the first byte and size of the contents
+     - Closing: Release the mapping when the object is destroyed
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+class MappedFile {
+private:
+    /******** Data Members ********/
+    const char *contents;  // First byte of the file contents
+    size_t length;         // Number of bytes in the file
+    bool mapped;           // True if contents is a memory mapping
+    string buffer;         // Holds the contents when the file could not be mapped
+
+public:
+    /******** Constructors ********/
+    MappedFile();
+    /*----------------------------------------------------------------------
+    Construct a MappedFile that holds no file.
+
+    Precondition:  None.
+    Postcondition: isOpen() returns false.
+    -----------------------------------------------------------------------*/
+
+    ~MappedFile();
+    /*----------------------------------------------------------------------
+    Release the file contents.
+
+    Precondition:  None.
+    Postcondition: Any mapping held by the object is removed.
+    -----------------------------------------------------------------------*/
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /******** File Access ********/
+    bool open(const string &filePath);
+    /*----------------------------------------------------------------------
+    Map a file into memory.
+
+    Precondition:  None.
+    Postcondition: Returns true and exposes the file contents through
+    data() and size() if the file could be opened, otherwise false.
+    -----------------------------------------------------------------------*/
+
+    void close();
+    /*----------------------------------------------------------------------
+    Release the file contents.
+
+    Precondition:  None.
+    Postcondition: isOpen() returns false.
+    -----------------------------------------------------------------------*/
+
+    bool isOpen() const;
+    /*----------------------------------------------------------------------
+    Check whether a file is currently held.
+
+    Precondition:  None.
+    Postcondition: Returns true after a successful open().
+    -----------------------------------------------------------------------*/
+
+    const char *data() const;
+    /*----------------------------------------------------------------------
+    Get the file contents.
+
+    Precondition:  isOpen() is true.
+    Postcondition: Returns a pointer to size() bytes; the contents are not
+    NUL-terminated.
+    -----------------------------------------------------------------------*/
+
+    size_t size() const;
+    /*----------------------------------------------------------------------
+    Get the size of the file contents.
+
+    Precondition:  None.
+    Postcondition: Returns the number of bytes available through data().
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,173 @@
+#include "Money.h"
+#include <cmath>
+
+// Constructors
+Money::Money()
+ : cents(0) {}
+
+Money Money::fromCents(int64_t c) {
+    Money amount;
+    amount.cents = c;
+    return amount;
+}
+
+Money Money::fromDouble(double value) {
+    return fromCents(llround(value * 100.0));
+}
+
+// Getters
+int64_t Money::getCents() const {
+    return cents;
+}
+
+double Money::toDouble() const {
+    return cents / 100.0;
+}
+
+// Arithmetic
+Money Money::operator+(Money other) const {
+    return fromCents(cents + other.cents);
+}
+
+Money Money::operator-(Money other) const {
+    return fromCents(cents - other.cents);
+}
+
+Money Money::operator-() const {
+    return fromCents(-cents);
+}
+
+Money &Money::operator+=(Money other) {
+    cents += other.cents;
+    return *this;
+}
+
+Money &Money::operator-=(Money other) {
+    cents -= other.cents;
+    return *this;
+}
+
+// Comparison
+bool Money::operator==(Money other) const { return cents == other.cents; }
+bool Money::operator!=(Money other) const { return cents != other.cents; }
+bool Money::operator<(Money other) const { return cents < other.cents; }
+bool Money::operator>(Money other) const { return cents > other.cents; }
+bool Money::operator<=(Money other) const { return cents <= other.cents; }
+bool Money::operator>=(Money other) const { return cents >= other.cents; }
+
+// Parsing
+bool Money::parse(const char *begin, const char *end, Money &amount) {
+    const char *p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Whole units; at most 16 digits so the cent count cannot overflow
+    int64_t units = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (++digits > 16) {
+            return false;
+        }
+        units = units * 10 + (*p - '0');
+        p++;
+    }
+
+    // Cents, rounding on the third decimal
+    int64_t fraction = 0;
+    int fractionDigits = 0;
+    bool roundUp = false;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (fractionDigits < 2) {
+                fraction = fraction * 10 + (*p - '0');
+            } else if (fractionDigits == 2) {
+                roundUp = (*p >= '5');
+            }
+            fractionDigits++;
+            p++;
+        }
+    }
+    if (p != end || digits + fractionDigits == 0) {
+        return false;
+    }
+    if (fractionDigits == 1) {
+        fraction *= 10;
+    }
+
+    int64_t total = units * 100 + fraction + (roundUp ? 1 : 0);
+    amount.cents = negative ? -total : total;
+    return true;
+}
+
+// Formatting
+static char *writeUnsigned(char *buffer, uint64_t value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+        *buffer++ = digits[--n];
+    }
+    return buffer;
+}
+
+char *Money::format(char *buffer) const {
+    uint64_t magnitude = cents < 0 ? 0 - (uint64_t)cents : (uint64_t)cents;
+    if (cents < 0) {
+        *buffer++ = '-';
+    }
+    buffer = writeUnsigned(buffer, magnitude / 100);
+    int fraction = int(magnitude % 100);
+    if (fraction != 0) {
+        *buffer++ = '.';
+        *buffer++ = char('0' + fraction / 10);
+        if (fraction % 10 != 0) {
+            *buffer++ = char('0' + fraction % 10);
+        }
+    }
+    return buffer;
+}
+
+char *Money::formatFixed(char *buffer) const {
+    uint64_t magnitude = cents < 0 ? 0 - (uint64_t)cents : (uint64_t)cents;
+    if (cents < 0) {
+        *buffer++ = '-';
+    }
+    buffer = writeUnsigned(buffer, magnitude / 100);
+    int fraction = int(magnitude % 100);
+    *buffer++ = '.';
+    *buffer++ = char('0' + fraction / 10);
+    *buffer++ = char('0' + fraction % 10);
+    return buffer;
+}
+
+string Money::toString() const {
+    char buffer[MAX_FORMATTED_LENGTH];
+    return string(buffer, format(buffer));
+}
+
+string Money::toFixedString() const {
+    char buffer[MAX_FORMATTED_LENGTH];
+    return string(buffer, formatFixed(buffer));
+}
+
+// Stream operators
+ostream &operator<<(ostream &out, Money amount) {
+    char buffer[Money::MAX_FORMATTED_LENGTH];
+    out.write(buffer, amount.format(buffer) - buffer);
+    return out;
+}
+
+istream &operator>>(istream &in, Money &amount) {
+    string token;
+    if (in >> token && !Money::parse(token.data(), token.data() + token.size(), amount)) {
+        in.setstate(ios::failbit);
+    }
+    return in;
+}
@@ -0,0 +1,160 @@
+/*-- Money.h -----------------------------------------------------------------
+
+  This header file defines the Money class, an exact fixed-point amount
+  stored as a signed 64-bit count of cents (minor units).
+
+  Basic operations include:
+     - Constructors: Zero amount, from cents, from a double
+     - Arithmetic: Exact addition, subtraction and negation
+     - Comparison: Equality and ordering
+     - Parsing: Decimal text to Money without stod
+     - Formatting: Money to decimal text without iostream precision state
+     - Stream Operations: Input and output operators for the Money class
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <cstdint>
+
+using namespace std;
+
+class Money {
+private:
+    /******** Data Members ********/
+    int64_t cents;   // Amount in minor units (1/100)
+
+public:
+    /******** Constants ********/
+    static const int MAX_FORMATTED_LENGTH = 24; // Longest text written by format/formatFixed
+
+    /******** Constructors ********/
+    Money();
+    /*----------------------------------------------------------------------
+    Construct a zero amount.
+
+    Precondition:  None.
+    Postcondition: The amount is 0.
+    -----------------------------------------------------------------------*/
+
+    static Money fromCents(int64_t cents);
+    /*----------------------------------------------------------------------
+    Construct an amount from a number of cents.
+
+    Precondition:  None.
+    Postcondition: Returns an amount of cents / 100.
+    -----------------------------------------------------------------------*/
+
+    static Money fromDouble(double amount);
+    /*----------------------------------------------------------------------
+    Construct an amount from a double, rounding to the nearest cent.
+
+    Precondition:  amount is finite and within the int64 cent range.
+    Postcondition: Returns the amount rounded half away from zero.
+    -----------------------------------------------------------------------*/
+
+    /******** Getters ********/
+    int64_t getCents() const;
+    /*----------------------------------------------------------------------
+    Get the amount in cents.
+
+    Precondition:  None.
+    Postcondition: Returns the number of cents.
+    -----------------------------------------------------------------------*/
+
+    double toDouble() const;
+    /*----------------------------------------------------------------------
+    Get the amount as a double, for display or interoperability only.
+
+    Precondition:  None.
+    Postcondition: Returns cents / 100.0.
+    -----------------------------------------------------------------------*/
+
+    /******** Arithmetic ********/
+    Money operator+(Money other) const;
+    Money operator-(Money other) const;
+    Money operator-() const;
+    Money &operator+=(Money other);
+    Money &operator-=(Money other);
+    /*----------------------------------------------------------------------
+    Exact arithmetic on cent counts.
+
+    Precondition:  The result fits in int64 cents.
+    Postcondition: Returns (or stores) the exact sum or difference.
+    -----------------------------------------------------------------------*/
+
+    /******** Comparison ********/
+    bool operator==(Money other) const;
+    bool operator!=(Money other) const;
+    bool operator<(Money other) const;
+    bool operator>(Money other) const;
+    bool operator<=(Money other) const;
+    bool operator>=(Money other) const;
+
+    /******** Parsing ********/
+    static bool parse(const char *begin, const char *end, Money &amount);
+    /*----------------------------------------------------------------------
+    Parse decimal text such as "12", "-3.5" or "+1040.25".
+
+    Precondition:  [begin, end) is a readable character range.
+    Postcondition: Returns true and stores the value in amount if the whole
+    range is a decimal number. Digits past the cents are rounded half away
+    from zero. Returns false (amount unchanged) otherwise.
+    -----------------------------------------------------------------------*/
+
+    /******** Formatting ********/
+    char *format(char *buffer) const;
+    /*----------------------------------------------------------------------
+    Write the shortest exact text: "0", "12.5", "-3.25".
+
+    Precondition:  buffer has room for MAX_FORMATTED_LENGTH characters.
+    Postcondition: Writes the text (not NUL-terminated) and returns a
+    pointer past its last character.
+    -----------------------------------------------------------------------*/
+
+    char *formatFixed(char *buffer) const;
+    /*----------------------------------------------------------------------
+    Write the text with exactly two decimals: "0.00", "12.50".
+
+    Precondition:  buffer has room for MAX_FORMATTED_LENGTH characters.
+    Postcondition: Writes the text (not NUL-terminated) and returns a
+    pointer past its last character.
+    -----------------------------------------------------------------------*/
+
+    string toString() const;
+    /*----------------------------------------------------------------------
+    Get the shortest exact text of the amount (see format).
+
+    Precondition:  None.
+    Postcondition: Returns the formatted amount.
+    -----------------------------------------------------------------------*/
+
+    string toFixedString() const;
+    /*----------------------------------------------------------------------
+    Get the amount with exactly two decimals (see formatFixed).
+
+    Precondition:  None.
+    Postcondition: Returns the formatted amount.
+    -----------------------------------------------------------------------*/
+
+    /******** Stream Operators ********/
+    friend ostream& operator<<(ostream &out, Money amount);
+    /*----------------------------------------------------------------------
+    Output stream insertion operator for a Money object.
+
+    Precondition:  The ostream 'out' is open.
+    Postcondition: Writes the shortest exact text of the amount; the
+    stream's precision and floatfield flags are not used.
+    -----------------------------------------------------------------------*/
+
+    friend istream& operator>>(istream &in, Money &amount);
+    /*----------------------------------------------------------------------
+    Input stream extraction operator for a Money object.
+
+    Precondition:  The istream 'in' is open.
+    Postcondition: Reads one whitespace-delimited token and parses it; sets
+    failbit if it is not a decimal number.
+    -----------------------------------------------------------------------*/
+};
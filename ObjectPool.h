@@ -0,0 +1,129 @@
+/*-- ObjectPool.h ------------------------------------------------------------
+
+  This header file defines the ObjectPool class template, an arena that
+  constructs objects in large contiguous chunks and destroys them all at
+  once.
+
+  Basic operations include:
+     - Allocation: Construct an object in the next free slot
+     - Bulk release: Destroy every object, keeping the chunks for reuse
+     - Teardown: Destroy every object and free the chunks
+
+  Objects never move, so pointers to them stay valid until clear() or the
+  pool's destruction. Individual objects cannot be released.
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template <typename T>
+class ObjectPool {
+private:
+    /******** Chunk Storage ********/
+    struct Chunk {
+        unique_ptr<unsigned char[]> storage;  // Raw memory for capacity objects
+        size_t capacity;                      // Number of slots in the chunk
+        size_t used;                          // Number of constructed objects
+    };
+
+    static const size_t FIRST_CHUNK = 256;     // Slots in the first chunk
+    static const size_t LARGEST_CHUNK = 65536; // Chunks stop growing at this size
+
+    vector<Chunk> chunks;  // Chunks in allocation order
+    size_t current;        // Chunk that receives the next object
+    size_t count;          // Number of live objects
+
+    T *slot(Chunk &chunk, size_t i) {
+        return reinterpret_cast<T *>(chunk.storage.get()) + i;
+    }
+
+public:
+    /******** Constructors ********/
+    ObjectPool() : current(0), count(0) {}
+    /*----------------------------------------------------------------------
+    Construct an empty pool.
+
+    Precondition:  None.
+    Postcondition: No memory is allocated until the first create().
+    -----------------------------------------------------------------------*/
+
+    ~ObjectPool() {
+        clear();
+    }
+    /*----------------------------------------------------------------------
+    Destroy every object and free all chunks.
+
+    Precondition:  None.
+    Postcondition: All memory held by the pool is released.
+    -----------------------------------------------------------------------*/
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /******** Allocation ********/
+    template <typename... Args>
+    T *create(Args &&... args) {
+        while (current < chunks.size() && chunks[current].used == chunks[current].capacity) {
+            current++;
+        }
+        if (current == chunks.size()) {
+            size_t capacity = chunks.empty() ? FIRST_CHUNK
+                            : min(chunks.back().capacity * 2, LARGEST_CHUNK);
+            Chunk chunk;
+            chunk.storage.reset(new unsigned char[capacity * sizeof(T)]);
+            chunk.capacity = capacity;
+            chunk.used = 0;
+            chunks.push_back(move(chunk));
+        }
+        Chunk &chunk = chunks[current];
+        T *object = new (slot(chunk, chunk.used)) T(forward<Args>(args)...);
+        chunk.used++;
+        count++;
+        return object;
+    }
+    /*----------------------------------------------------------------------
+    Construct an object in the pool.
+
+    Precondition:  args are valid constructor arguments for T.
+    Postcondition: Returns a pointer to the new object. A new chunk is
+    allocated only when every existing chunk is full.
+    -----------------------------------------------------------------------*/
+
+    /******** Release ********/
+    void clear() {
+        for (Chunk &chunk : chunks) {
+            for (size_t i = 0; i < chunk.used; i++) {
+                slot(chunk, i)->~T();
+            }
+            chunk.used = 0;
+        }
+        current = 0;
+        count = 0;
+    }
+    /*----------------------------------------------------------------------
+    Destroy every object in the pool.
+
+    Precondition:  No pointer into the pool is used afterwards.
+    Postcondition: The pool is empty; its chunks are kept and reused by
+    later create() calls.
+    -----------------------------------------------------------------------*/
+
+    size_t size() const {
+        return count;
+    }
+    /*----------------------------------------------------------------------
+    Get the number of live objects.
+
+    Precondition:  None.
+    Postcondition: Returns the number of objects created since the last
+    clear().
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,66 @@
+#include "OutputBuffer.h"
+#include <charconv>
+#include <algorithm>
+
+const size_t OutputBuffer::BLOCK_SIZE;
+const size_t OutputBuffer::FIRST_SIZE;
+
+OutputBuffer::OutputBuffer(ostream & out)
+ : out(&out), capacity(0), used(0) {}
+
+OutputBuffer::OutputBuffer()
+ : out(nullptr), capacity(0), used(0) {}
+
+OutputBuffer::~OutputBuffer() {
+    flush();
+}
+
+void OutputBuffer::grow(size_t bytes) {
+    if (out != nullptr && used > 0 && used + bytes > BLOCK_SIZE) {
+        flush();
+        if (bytes <= capacity) {
+            return;
+        }
+    }
+    size_t size = max(max(capacity * 2, FIRST_SIZE), used + bytes);
+    if (out != nullptr) {
+        size = max(min(size, BLOCK_SIZE), used + bytes);
+    }
+    unique_ptr<char[]> larger(new char[size]);
+    if (used > 0) {
+        memcpy(larger.get(), buffer.get(), used);
+    }
+    buffer = move(larger);
+    capacity = size;
+}
+
+void OutputBuffer::writeInt(long long value) {
+    char * start = reserve(24);
+    used += to_chars(start, start + 24, value).ptr - start;
+}
+
+void OutputBuffer::writeMoney(Money amount) {
+    char * start = reserve(Money::MAX_FORMATTED_LENGTH);
+    used += amount.format(start) - start;
+}
+
+void OutputBuffer::writeMoneyFixed(Money amount) {
+    char * start = reserve(Money::MAX_FORMATTED_LENGTH);
+    used += amount.formatFixed(start) - start;
+}
+
+void OutputBuffer::flush() {
+    if (out == nullptr || used == 0) {
+        return;
+    }
+    out->write(buffer.get(), used);
+    used = 0;
+}
+
+string_view OutputBuffer::view() const {
+    return string_view(buffer.get(), used);
+}
+
+void OutputBuffer::clear() {
+    used = 0;
+}
@@ -0,0 +1,159 @@
+/*-- OutputBuffer.h ----------------------------------------------------------
+
+  This header file defines the OutputBuffer class, which collects report
+  text in a reusable memory block and writes it to an output stream in big
+  chunks. The block starts small and doubles as text arrives, up to 1 MiB
+  for a stream, so short reports allocate little; its bytes are never
+  zero-filled.
+
+  Basic operations include:
+     - Appending: Characters, strings, repeated characters
+     - Number formatting: Integers and Money amounts written straight into
+       the buffer without iostream formatting
+     - Flushing: Write the collected text to the stream
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string_view>
+#include <memory>
+#include <iostream>
+#include <cstring>
+#include "Money.h"
+
+using namespace std;
+
+class OutputBuffer {
+private:
+    /******** Data Members ********/
+    static const size_t BLOCK_SIZE = 1 << 20;   // Bytes collected before a flush
+    static const size_t FIRST_SIZE = 1 << 12;   // Bytes allocated by the first append
+
+    ostream *out;               // Destination stream, or nullptr to keep text in memory
+    unique_ptr<char[]> buffer;  // Pending text, uninitialized past used
+    size_t capacity;            // Bytes allocated in buffer
+    size_t used;                // Number of pending bytes
+
+    /******** Private Member Functions ********/
+    char *reserve(size_t bytes) {
+        if (used + bytes > capacity) {
+            grow(bytes);
+        }
+        return buffer.get() + used;
+    }
+    /*----------------------------------------------------------------------
+    Make room for bytes more characters.
+
+    Precondition:  None.
+    Postcondition: Returns a pointer to at least bytes writable characters
+    after the pending text.
+    -----------------------------------------------------------------------*/
+
+    void grow(size_t bytes);
+    /*----------------------------------------------------------------------
+    Make room for bytes more characters when the block is full.
+
+    Precondition:  used + bytes > capacity.
+    Postcondition: A stream buffer that would pass BLOCK_SIZE is flushed
+    first. The block then holds at least used + bytes characters; it has
+    at least doubled if it had to grow, without passing BLOCK_SIZE for a
+    stream unless one append needs more.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    explicit OutputBuffer(ostream &out);
+    /*----------------------------------------------------------------------
+    Construct a buffer that writes to a stream.
+
+    Precondition:  out is open and outlives the buffer.
+    Postcondition: Text is written to out in blocks of about 1 MiB.
+    -----------------------------------------------------------------------*/
+
+    OutputBuffer();
+    /*----------------------------------------------------------------------
+    Construct a buffer that keeps all text in memory.
+
+    Precondition:  None.
+    Postcondition: Text accumulates until it is read with view(). Nothing
+    is allocated until the first append.
+    -----------------------------------------------------------------------*/
+
+    ~OutputBuffer();
+    /*----------------------------------------------------------------------
+    Flush pending text to the stream, if there is one.
+
+    Precondition:  None.
+    Postcondition: All text has been written.
+    -----------------------------------------------------------------------*/
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    /******** Appending ********/
+    void put(char c) {
+        *reserve(1) = c;
+        used++;
+    }
+    /*----------------------------------------------------------------------
+    Append one character.
+    -----------------------------------------------------------------------*/
+
+    void write(string_view text) {
+        memcpy(reserve(text.size()), text.data(), text.size());
+        used += text.size();
+    }
+    /*----------------------------------------------------------------------
+    Append a string.
+    -----------------------------------------------------------------------*/
+
+    void fill(char c, size_t count) {
+        memset(reserve(count), c, count);
+        used += count;
+    }
+    /*----------------------------------------------------------------------
+    Append count copies of a character (used for indentation).
+    -----------------------------------------------------------------------*/
+
+    void writeInt(long long value);
+    /*----------------------------------------------------------------------
+    Append an integer in decimal.
+    -----------------------------------------------------------------------*/
+
+    void writeMoney(Money amount);
+    /*----------------------------------------------------------------------
+    Append an amount in its shortest exact form ("0", "12.5").
+    -----------------------------------------------------------------------*/
+
+    void writeMoneyFixed(Money amount);
+    /*----------------------------------------------------------------------
+    Append an amount with exactly two decimals ("12.50").
+    -----------------------------------------------------------------------*/
+
+    /******** Output ********/
+    void flush();
+    /*----------------------------------------------------------------------
+    Write the pending text to the stream.
+
+    Precondition:  None.
+    Postcondition: The buffer is empty if it has a stream; an in-memory
+    buffer is left unchanged.
+    -----------------------------------------------------------------------*/
+
+    string_view view() const;
+    /*----------------------------------------------------------------------
+    Get the pending text.
+
+    Precondition:  None.
+    Postcondition: Returns the text appended since the last flush.
+    -----------------------------------------------------------------------*/
+
+    void clear();
+    /*----------------------------------------------------------------------
+    Drop the pending text without writing it.
+
+    Precondition:  None.
+    Postcondition: The buffer is empty; its memory is kept for reuse.
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,53 @@
+#include "RadixSort.h"
+
+const vector<uint32_t> & TransactionSorter::order(const vector<int> & ids) {
+    size_t n = ids.size();
+    positions.resize(n);
+    if (n < 2) {
+        for (size_t i = 0; i < n; i++) {
+            positions[i] = i;
+        }
+        return positions;
+    }
+
+    // Key = ID with its sign bit flipped (so negative IDs order first) in
+    // the high half, original position in the low half
+    keys.resize(n);
+    scratch.resize(n);
+    size_t count[4][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        uint32_t id = (uint32_t)ids[i] ^ 0x80000000u;
+        keys[i] = ((uint64_t)id << 32) | i;
+        count[0][id & 0xFF]++;
+        count[1][(id >> 8) & 0xFF]++;
+        count[2][(id >> 16) & 0xFF]++;
+        count[3][id >> 24]++;
+    }
+
+    // One stable counting pass per ID byte
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = 32 + pass * 8;
+        size_t * bucket = count[pass];
+
+        // Skip the pass if every key has the same byte here
+        if (bucket[(keys[0] >> shift) & 0xFF] == n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = bucket[b];
+            bucket[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            scratch[bucket[(keys[i] >> shift) & 0xFF]++] = keys[i];
+        }
+        keys.swap(scratch);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        positions[i] = keys[i] & 0xFFFFFFFFu;
+    }
+    return positions;
+}
@@ -0,0 +1,68 @@
+/*-- RadixSort.h -------------------------------------------------------------
+
+  This header file defines the TransactionSorter class, which orders a
+  column of transaction IDs using a least-significant-digit radix sort in
+  base 256.
+
+  Basic operations include:
+     - Ordering: Stable ascending-ID order of an ID column
+     - Gathering: Rearranging another column into that order
+
+  The sorter works on 64-bit (ID, position) keys built from the ID column
+  alone, ping-pongs between two key buffers and skips byte passes in which
+  every key falls into the same bucket. The other columns of a store are
+  then gathered once each. Its buffers are kept between calls so repeated
+  sorts do not allocate.
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+class TransactionSorter {
+private:
+    /******** Data Members ********/
+    vector<uint64_t> keys;          // (ID, position) keys being sorted
+    vector<uint64_t> scratch;       // Second key buffer for ping-pong passes
+    vector<uint32_t> positions;     // Source position of each sorted slot
+    vector<char> gathered;          // Column bytes in sorted order before the copy back
+
+public:
+    /******** Ordering ********/
+    const vector<uint32_t> &order(const vector<int> &ids);
+    /*----------------------------------------------------------------------
+    Compute the ascending-ID order of an ID column.
+
+    Precondition:  ids holds fewer than 2^32 elements.
+    Postcondition: Returns positions such that ids[positions[0]],
+    ids[positions[1]], ... is ascending; equal IDs keep their relative
+    order. The result stays valid until the next call.
+    -----------------------------------------------------------------------*/
+
+    /******** Gathering ********/
+    template <typename T>
+    void gather(vector<T> &column);
+    /*----------------------------------------------------------------------
+    Rearrange a column into the order computed by the last order() call.
+
+    Precondition:  order() was called on a column of column.size()
+    elements, and T is trivially copyable.
+    Postcondition: column[i] holds the former column[positions[i]].
+    -----------------------------------------------------------------------*/
+};
+
+template <typename T>
+void TransactionSorter::gather(vector<T> & column) {
+    size_t n = column.size();
+    gathered.resize(n * sizeof(T));
+    T * sorted = reinterpret_cast<T *>(gathered.data());
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = column[positions[i]];
+    }
+    memcpy(column.data(), sorted, n * sizeof(T));
+}
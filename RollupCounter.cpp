@@ -0,0 +1,33 @@
+#include "RollupCounter.h"
+
+RollupCounter::RollupCounter() {
+    for (Shard & shard : shards) {
+        shard.cents.store(0, memory_order_relaxed);
+    }
+}
+
+size_t RollupCounter::threadShard() {
+    static atomic<size_t> nextShard(0);
+    static thread_local size_t shard = nextShard.fetch_add(1, memory_order_relaxed) % SHARD_COUNT;
+    return shard;
+}
+
+void RollupCounter::add(Money amount) {
+    shards[threadShard()].cents.fetch_add(amount.getCents(), memory_order_relaxed);
+}
+
+Money RollupCounter::sum() const {
+    int64_t total = 0;
+    for (const Shard & shard : shards) {
+        total += shard.cents.load(memory_order_relaxed);
+    }
+    return Money::fromCents(total);
+}
+
+Money RollupCounter::drain() {
+    int64_t total = 0;
+    for (Shard & shard : shards) {
+        total += shard.cents.exchange(0, memory_order_relaxed);
+    }
+    return Money::fromCents(total);
+}
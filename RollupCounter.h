@@ -0,0 +1,88 @@
+/*-- RollupCounter.h ---------------------------------------------------------
+
+  This header file defines the RollupCounter class, a lock-free amount
+  accumulator for accounts that many threads roll changes into at once
+  (the top levels of the chart in concurrent mode).
+
+  Each thread adds into one of several shards, each on its own cache line,
+  so concurrent writers neither wait for each other nor bounce one line
+  between cores. Readers combine the shards.
+
+  Basic operations include:
+     - Accumulation: Add an amount into the calling thread's shard
+     - Reading: Sum of everything added and not yet drained
+     - Draining: Take the sum out of the counter
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Money.h"
+
+using namespace std;
+
+class RollupCounter {
+private:
+    /******** Data Members ********/
+    static const size_t SHARD_COUNT = 16;   // Threads beyond this share shards
+
+    struct alignas(64) Shard {
+        atomic<int64_t> cents;             // Cents added through this shard
+    };
+    Shard shards[SHARD_COUNT];
+
+    /******** Private Member Functions ********/
+    static size_t threadShard();
+    /*----------------------------------------------------------------------
+    Get the shard used by the calling thread.
+
+    Precondition:  None.
+    Postcondition: Returns the same index on every call from one thread;
+    threads are spread over the shards round-robin.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    RollupCounter();
+    /*----------------------------------------------------------------------
+    Construct an empty counter.
+
+    Precondition:  None.
+    Postcondition: sum() returns zero.
+    -----------------------------------------------------------------------*/
+
+    RollupCounter(const RollupCounter &) = delete;
+    RollupCounter &operator=(const RollupCounter &) = delete;
+
+    /******** Accumulation ********/
+    void add(Money amount);
+    /*----------------------------------------------------------------------
+    Add an amount to the counter without locking.
+
+    Precondition:  None.
+    Postcondition: The amount is included in later sums and drains.
+    -----------------------------------------------------------------------*/
+
+    /******** Reading ********/
+    Money sum() const;
+    /*----------------------------------------------------------------------
+    Get the total added since the last drain.
+
+    Precondition:  None.
+    Postcondition: Returns the combined shards. Amounts added while the
+    shards are being read may or may not be included.
+    -----------------------------------------------------------------------*/
+
+    Money drain();
+    /*----------------------------------------------------------------------
+    Take the total out of the counter.
+
+    Precondition:  None.
+    Postcondition: Returns the combined shards and leaves each at zero.
+    Every amount added is returned by exactly one drain, even while other
+    threads keep adding.
+    -----------------------------------------------------------------------*/
+};
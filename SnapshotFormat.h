@@ -0,0 +1,81 @@
+/*-- SnapshotFormat.h --------------------------------------------------------
+
+  This header file defines the on-disk layout of a binary ForestTree
+  snapshot (see ForestTree::saveSnapshot and ForestTree::loadSnapshot).
+
+  A snapshot file is laid out as:
+     - SnapshotHeader
+     - SnapshotAccount[accountCount]       accounts in report order (preorder)
+     - SnapshotTransaction[transactionCount] grouped per account, in ID order
+     - description bytes                   all descriptions back to back
+
+  Every section starts on an 8-byte boundary and all integers are in host
+  byte order; byteOrderMark detects files written on a machine with the
+  other byte order. checksum covers every byte after the header.
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/******** Constants ********/
+static const char SNAPSHOT_MAGIC[8] = {'F', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+static const uint32_t SNAPSHOT_VERSION = 2;   // 2: transactions carry a date
+static const uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+
+/******** Records ********/
+struct SnapshotHeader {
+    char magic[8];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t byteOrderMark;     // SNAPSHOT_BYTE_ORDER_MARK as written by the saver
+    uint64_t accountCount;      // Number of SnapshotAccount records
+    uint64_t transactionCount;  // Number of SnapshotTransaction records
+    uint64_t descriptionBytes;  // Size of the description section
+    uint64_t checksum;          // snapshotChecksum of everything after the header
+    uint64_t reserved[2];       // Zero
+};
+
+struct SnapshotAccount {
+    int32_t accountNumber;      // Account number
+    uint32_t depth;             // Depth below the root level
+    int64_t balanceCents;       // Rolled-up balance
+    int64_t ownBalanceCents;    // Opening balance plus own transactions
+    uint64_t descriptionOffset; // Start of the description in the description section
+    uint64_t descriptionLength; // Description length in bytes
+    uint64_t transactionCount;  // Number of transaction records that belong to this account
+};
+
+struct SnapshotTransaction {
+    int32_t id;                 // Transaction ID
+    int32_t type;               // 'D' or 'C'
+    int64_t amountCents;        // Non-negative amount
+    int32_t date;               // Posting date as yyyymmdd, or 0 if undated
+    int32_t reserved;           // Zero
+};
+
+/******** Checksum ********/
+inline uint64_t snapshotChecksum(const char *data, size_t size) {
+    // FNV-1a style mixing over 8-byte words, then the tail bytes
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * prime;
+    }
+    return hash;
+}
+/*--------------------------------------------------------------------------
+Compute the snapshot checksum of a block of bytes.
+
+Precondition:  data points to size readable bytes.
+Postcondition: Returns a 64-bit checksum; any single-word change alters it.
+--------------------------------------------------------------------------*/
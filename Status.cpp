@@ -0,0 +1,32 @@
+#include "Status.h"
+#include <atomic>
+
+static atomic<DiagnosticSink *> installedSink(nullptr);
+
+const char * statusMessage(Status status) {
+    switch (status) {
+        case Status::Ok:                   return "Success";
+        case Status::InvalidAccountNumber: return "Invalid account number";
+        case Status::InvalidTransactionId: return "Invalid transaction ID";
+        case Status::InvalidDate:          return "Invalid date";
+        case Status::InvalidFormat:        return "Invalid record format";
+        case Status::AccountExists:        return "Account already exists";
+        case Status::ParentMissing:        return "Parent account does not exist";
+        case Status::AccountNotFound:      return "Account not found";
+        case Status::TransactionExists:    return "Transaction already exists";
+        case Status::TransactionNotFound:  return "Transaction not found";
+        case Status::FileError:            return "File could not be opened or written";
+        case Status::VersionMismatch:      return "Unsupported file version";
+        case Status::ChecksumMismatch:     return "File checksum does not match";
+        case Status::JournalError:         return "Journal could not be written";
+    }
+    return "Unknown status";
+}
+
+void setDiagnosticSink(DiagnosticSink * sink) {
+    installedSink.store(sink);
+}
+
+DiagnosticSink * getDiagnosticSink() {
+    return installedSink.load(memory_order_acquire);
+}
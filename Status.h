@@ -0,0 +1,94 @@
+/*-- Status.h ----------------------------------------------------------------
+
+  This header file defines the result codes returned by the core classes
+  and the optional sink that receives their diagnostic messages.
+
+  The core classes never write to the console themselves. Operations
+  return a Status (or bool where only success matters), and a diagnostic
+  describing each failure is passed to the installed DiagnosticSink. No
+  sink is installed by default, so a library user that does not install
+  one gets no I/O and does not pay for building the messages.
+
+  Basic operations include:
+     - Status codes and their generic messages
+     - Installing a sink
+     - Reporting a diagnostic
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+/******** Result Codes ********/
+enum class Status {
+    Ok,                     // The operation succeeded
+    InvalidAccountNumber,   // Account numbers must be positive
+    InvalidTransactionId,   // Transaction IDs must be positive
+    InvalidDate,            // Dates must be 0 or a valid yyyymmdd day
+    InvalidFormat,          // A record could not be parsed
+    AccountExists,          // The account number is already in the tree
+    ParentMissing,          // The account's top-level account does not exist
+    AccountNotFound,        // No account has this number
+    TransactionExists,      // Some account already holds this transaction ID
+    TransactionNotFound,    // The account holds no transaction with this ID
+    FileError,              // A file could not be opened or written
+    VersionMismatch,        // A file was written in an unsupported format version
+    ChecksumMismatch,       // A file's contents do not match its checksum
+    JournalError            // A posting could not be written to the journal
+};
+
+const char *statusMessage(Status status);
+/*--------------------------------------------------------------------------
+Get a generic description of a status.
+
+Precondition:  None.
+Postcondition: Returns a short, constant English description.
+--------------------------------------------------------------------------*/
+
+/******** Diagnostics ********/
+class DiagnosticSink {
+public:
+    virtual ~DiagnosticSink() = default;
+
+    virtual void report(Status status, const string &message) = 0;
+    /*----------------------------------------------------------------------
+    Receive one diagnostic.
+
+    Precondition:  status is not Status::Ok.
+    Postcondition: Handled as the sink sees fit. May be called from
+    several threads when the tree is used concurrently.
+    -----------------------------------------------------------------------*/
+};
+
+void setDiagnosticSink(DiagnosticSink *sink);
+/*--------------------------------------------------------------------------
+Install the sink that receives diagnostics from the core classes.
+
+Precondition:  sink is nullptr or outlives its installation.
+Postcondition: Later diagnostics go to sink; nullptr discards them.
+--------------------------------------------------------------------------*/
+
+DiagnosticSink *getDiagnosticSink();
+/*--------------------------------------------------------------------------
+Get the installed sink.
+
+Precondition:  None.
+Postcondition: Returns the sink, or nullptr if none is installed.
+--------------------------------------------------------------------------*/
+
+template <typename Message>
+void diagnose(Status status, Message message) {
+    if (DiagnosticSink * sink = getDiagnosticSink()) {
+        sink->report(status, message());
+    }
+}
+/*--------------------------------------------------------------------------
+Report a diagnostic to the installed sink.
+
+Precondition:  message() returns the text of the diagnostic.
+Postcondition: If a sink is installed, it receives status and the text.
+Otherwise nothing happens and message is not called.
+--------------------------------------------------------------------------*/
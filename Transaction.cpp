@@ -1,22 +1,30 @@
 #include "Transaction.h"
+#include <cstdio>
 
 // Constructors
 Transaction::Transaction()
- : id(0), amount(0.0), type('D') {}
+ : id(0), date(0), amount(), type('D') {}
 
 Transaction::Transaction(int id)
- : id(id), amount(0.0), type('D') {}
+ : id(id), date(0), amount(), type('D') {}
 
-Transaction::Transaction(int id, double amount, char type)
- : amount(amount), type(type) {
+Transaction::Transaction(int id, Money amount, char type, int date)
+ : id(0), date(0), amount(amount), type(type) {
     setId(id);
+    if (date != 0) {
+        setDate(date);
+    }
  }
 
 // Getters
-double Transaction::getAmount() const {
+Money Transaction::getAmount() const {
     return amount;
 }
 
+Money Transaction::getSignedAmount() const {
+    return type == 'C' ? -amount : amount;
+}
+
 char Transaction::getType() const {
     return type;
 }
@@ -25,6 +33,24 @@ int Transaction::getId() const {
     return id;
 }
 
+int Transaction::getDate() const {
+    return date;
+}
+
+bool Transaction::isDated() const {
+    return date != 0;
+}
+
+bool Transaction::isValidDate(int date) {
+    static const int DAYS_IN_MONTH[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year = date / 10000, month = date / 100 % 100, day = date % 100;
+    if (year < 1 || year > 9999 || month < 1 || month > 12 || day < 1) {
+        return false;
+    }
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return day <= DAYS_IN_MONTH[month - 1] - (month == 2 && !leap);
+}
+
 // Setters
 bool Transaction::setType(char type) {
     if (tolower(type) == 'd' || tolower(type) == 'c') {
@@ -34,51 +60,93 @@ bool Transaction::setType(char type) {
     return false;
 }
 
-void Transaction::setId(int id) {
-	if (id < 1) {
-        cerr << "Invalid Transaction ID\n";
-        return;
+Status Transaction::setId(int id) {
+    if (id < 1) {
+        diagnose(Status::InvalidTransactionId, [] { return string("Invalid Transaction ID"); });
+        return Status::InvalidTransactionId;
+    }
+    this->id = id;
+    return Status::Ok;
+}
+
+Status Transaction::setDate(int date) {
+    if (date != 0 && !isValidDate(date)) {
+        diagnose(Status::InvalidDate, [&] { return "Invalid transaction date " + to_string(date); });
+        return Status::InvalidDate;
     }
-    this->id= id;
+    this->date = date;
+    return Status::Ok;
+}
+
+// Large enough for any int, so the date format cannot truncate
+static const size_t DATE_TEXT_SIZE = 16;
+
+// Writes yyyy-mm-dd
+static void formatDate(int date, char * text) {
+    snprintf(text, DATE_TEXT_SIZE, "%04d-%02d-%02d", date / 10000, date / 100 % 100, date % 100);
 }
 
 void Transaction::printWithIndentation(int depth, ostream& out) const {
     string indent = string(depth * 2, ' ');
     out << indent << "Transaction ID: " << id << '\n';
-    out << indent + "  " << "Amount: " << fixed << setprecision(2) << amount << '\n';
+    out << indent + "  " << "Amount: " << amount.toFixedString() << '\n';
     out << indent + "  " << "Type: " << (type == 'D' ? "Debit" : "Credit") << '\n';
+    if (date != 0) {
+        char text[DATE_TEXT_SIZE];
+        formatDate(date, text);
+        out << indent + "  " << "Date: " << text << '\n';
+    }
+}
+
+void Transaction::printWithIndentation(int depth, OutputBuffer& out) const {
+    out.fill(' ', depth * 2);
+    out.write("Transaction ID: ");
+    out.writeInt(id);
+    out.put('\n');
+    out.fill(' ', depth * 2 + 2);
+    out.write("Amount: ");
+    out.writeMoneyFixed(amount);
+    out.put('\n');
+    out.fill(' ', depth * 2 + 2);
+    out.write(type == 'D' ? "Type: Debit\n" : "Type: Credit\n");
+    if (date != 0) {
+        char text[DATE_TEXT_SIZE];
+        formatDate(date, text);
+        out.fill(' ', depth * 2 + 2);
+        out.write("Date: ");
+        out.write(string_view(text, 10));
+        out.put('\n');
+    }
 }
 
 ostream& operator<<(ostream& out, const Transaction& trans) {
     out << "Transaction ID: " << trans.getId() << "\n"
-        << "Amount: " << fixed << setprecision(2) << trans.getAmount() << "\n"
+        << "Amount: " << trans.getAmount().toFixedString() << "\n"
         << "Type: " << (trans.getType() == 'D' ? "Debit" : "Credit");
+    if (trans.isDated()) {
+        char text[DATE_TEXT_SIZE];
+        formatDate(trans.getDate(), text);
+        out << "\nDate: " << text;
+    }
     return out;
 }
 
 istream& operator>>(istream &in, Transaction &trans) {
     int id;
-    do {
-        cout << "Enter transaction ID: ";
-        in >> id;
-    } while(id <= 0);
-    trans.id = id;
-
-    double amount;
-    do {
-	    cout << "Enter transaction amount: ";
-        in >> amount;
-    } while(amount < 0);
-    trans.amount = amount;
-
-	cout << "Enter transaction type (D for debit, C for credit): ";
-	char type;
-    in >> type;
-
-	while(!trans.setType(type)) {
-		cerr << "Invalid transaction type! Use 'D' for debit or 'C' for credit!!\n";
-		cout << "Re-enter transaction type (D or C): ";
-		in >> type;
-	}
-	return in;
+    Money amount;
+    char type;
+    if (!(in >> id >> amount >> type)) {
+        return in;
+    }
+    if (id <= 0 || amount < Money()) {
+        in.setstate(ios::failbit);
+        return in;
+    }
+    Transaction read(id, amount, 'D');
+    if (!read.setType(type)) {
+        in.setstate(ios::failbit);
+        return in;
+    }
+    trans = read;
+    return in;
 }
\ No newline at end of file
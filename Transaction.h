@@ -16,6 +16,9 @@
 #include <string>
 #include <iostream>
 #include <iomanip>
+#include "Money.h"
+#include "OutputBuffer.h"
+#include "Status.h"
 
 using namespace std;
 
@@ -23,7 +26,8 @@ class Transaction {
 private:
     /******** Data Members ********/
     int id;        // Unique identifier for the transaction
-    double amount; // Transaction amount
+    int date;      // Posting date as yyyymmdd, or 0 if undated
+    Money amount;  // Transaction amount (non-negative)
     char type;     // Transaction type ('D' for deposit, 'W' for withdrawal, etc.)
 
 public:
@@ -34,7 +38,7 @@ public:
 
     Precondition:  None.
     Postcondition: A Transaction object is created with id = 0,
-    amount = 0.0, and type = '\0'.
+    amount = 0, and type = 'D'.
     -----------------------------------------------------------------------*/
 
     Transaction(int id);
@@ -43,20 +47,22 @@ public:
 
     Precondition:  id is a valid integer.
     Postcondition: A Transaction object is created with the given id,
-    amount = 0.0, and type = '\0'.
+    amount = 0, and type = 'D'.
     -----------------------------------------------------------------------*/
 
-    Transaction(int id, double amount, char type);
+    Transaction(int id, Money amount, char type, int date = 0);
     /*----------------------------------------------------------------------
-    Construct a Transaction object with specified ID, amount, and type.
+    Construct a Transaction object with specified ID, amount, type and
+    posting date.
 
-    Precondition:  id is a valid integer, amount is a valid double, and
+    Precondition:  id is a valid integer, amount is non-negative, and
     type is a valid character ('D', 'W', etc.).
     Postcondition: A Transaction object is created with the given values.
+    An invalid date is reported and leaves the transaction undated.
     -----------------------------------------------------------------------*/
 
     /******** Getters ********/
-    double getAmount() const;
+    Money getAmount() const;
     /*----------------------------------------------------------------------
     Get the amount of the transaction.
 
@@ -64,6 +70,15 @@ public:
     Postcondition: Returns the amount of the transaction.
     -----------------------------------------------------------------------*/
 
+    Money getSignedAmount() const;
+    /*----------------------------------------------------------------------
+    Get the effect of the transaction on its account's balance.
+
+    Precondition:  None.
+    Postcondition: Returns the amount for a debit and its negation for a
+    credit.
+    -----------------------------------------------------------------------*/
+
     char getType() const;
     /*----------------------------------------------------------------------
     Get the type of the transaction.
@@ -80,6 +95,31 @@ public:
     Postcondition: Returns the ID of the transaction.
     -----------------------------------------------------------------------*/
 
+    int getDate() const;
+    /*----------------------------------------------------------------------
+    Get the posting date of the transaction.
+
+    Precondition:  None.
+    Postcondition: Returns the date as yyyymmdd, or 0 if it is undated.
+    -----------------------------------------------------------------------*/
+
+    bool isDated() const;
+    /*----------------------------------------------------------------------
+    Check whether the transaction has a posting date.
+
+    Precondition:  None.
+    Postcondition: Returns true if getDate() is not 0.
+    -----------------------------------------------------------------------*/
+
+    static bool isValidDate(int date);
+    /*----------------------------------------------------------------------
+    Check a yyyymmdd date.
+
+    Precondition:  None.
+    Postcondition: Returns true if date names a day of the Gregorian
+    calendar between the years 1 and 9999.
+    -----------------------------------------------------------------------*/
+
     /******** Setters ********/
     bool setType(char type);
     /*----------------------------------------------------------------------
@@ -90,12 +130,24 @@ public:
     returns true; otherwise, returns false.
     -----------------------------------------------------------------------*/
 
-    void setId(int id);
+    Status setId(int id);
     /*----------------------------------------------------------------------
     Set the ID of the transaction.
 
     Precondition:  id is a valid integer.
-    Postcondition: Updates the transaction's ID.
+    Postcondition: Updates the transaction's ID and returns Status::Ok if
+    id is positive; otherwise the ID is unchanged, a diagnostic is
+    reported and Status::InvalidTransactionId is returned.
+    -----------------------------------------------------------------------*/
+
+    Status setDate(int date);
+    /*----------------------------------------------------------------------
+    Set the posting date of the transaction.
+
+    Precondition:  None.
+    Postcondition: Updates the date and returns Status::Ok if date is 0
+    (undated) or a valid yyyymmdd date; otherwise the date is unchanged,
+    a diagnostic is reported and Status::InvalidDate is returned.
     -----------------------------------------------------------------------*/
 
     /******** Printing ********/
@@ -109,6 +161,14 @@ public:
     specified indentation.
     -----------------------------------------------------------------------*/
 
+    void printWithIndentation(int indentation, OutputBuffer &out) const;
+    /*----------------------------------------------------------------------
+    Append the same text as above to an output buffer.
+
+    Precondition:  indentation is a non-negative integer.
+    Postcondition: The transaction details are appended to the buffer.
+    -----------------------------------------------------------------------*/
+
     /******** Stream Operators ********/
     friend ostream& operator<<(ostream &out, const Transaction &transaction);
     /*----------------------------------------------------------------------
@@ -124,7 +184,9 @@ public:
     Input stream extraction operator for a Transaction object.
 
     Precondition:  The istream 'in' is open.
-    Postcondition: Reads the transaction's ID, amount, and type from the
-    input stream and initializes the object.
+    Postcondition: Reads the transaction's ID, amount, and type (D or C)
+    as whitespace-separated fields, without prompting. If a field is
+    missing or invalid (ID not positive, negative amount, other type),
+    the failbit is set and the object is unchanged.
     -----------------------------------------------------------------------*/
 };
\ No newline at end of file
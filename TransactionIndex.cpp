@@ -0,0 +1,120 @@
+#include "TransactionIndex.h"
+#include <algorithm>
+
+const int TransactionIndex::NO_ACCOUNT;
+
+// Constructor
+TransactionIndex::TransactionIndex() : count(0), slotBits(0) {}
+
+// Probing
+size_t TransactionIndex::homeSlot(int id) const {
+    // Fibonacci hashing: the top bits of the product are well mixed
+    return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> (64 - slotBits));
+}
+
+size_t TransactionIndex::findSlot(int id) const {
+    if (slots.empty()) {
+        return 0;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t slot = homeSlot(id); ; slot = (slot + 1) & mask) {
+        const Entry & entry = slots[slot];
+        if (entry.account == NO_ACCOUNT) {
+            return slots.size();
+        }
+        if (entry.id == id) {
+            return slot;
+        }
+    }
+}
+
+void TransactionIndex::rehash(size_t capacity) {
+    vector<Entry> old;
+    old.swap(slots);
+    slotBits = 3;
+    while (((size_t)1 << slotBits) < capacity * 2) {
+        slotBits++;
+    }
+    slots.assign((size_t)1 << slotBits, Entry{0, NO_ACCOUNT});
+    size_t mask = slots.size() - 1;
+    for (const Entry & entry : old) {
+        if (entry.account == NO_ACCOUNT) {
+            continue;
+        }
+        size_t slot = homeSlot(entry.id);
+        while (slots[slot].account != NO_ACCOUNT) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = entry;
+    }
+}
+
+// Modification
+bool TransactionIndex::insert(int id, int account) {
+    if ((count + 1) * 2 > slots.size()) {
+        rehash(max(count + 1, slots.size()));
+    }
+    size_t mask = slots.size() - 1;
+    size_t slot = homeSlot(id);
+    for (; slots[slot].account != NO_ACCOUNT; slot = (slot + 1) & mask) {
+        if (slots[slot].id == id) {
+            return false;
+        }
+    }
+    slots[slot] = Entry{id, account};
+    count++;
+    return true;
+}
+
+bool TransactionIndex::erase(int id, int account) {
+    size_t slot = findSlot(id);
+    if (slot == slots.size() || slots[slot].account != account) {
+        return false;
+    }
+
+    // Move later entries of the run back unless their probe starts after the gap
+    size_t mask = slots.size() - 1;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        const Entry & entry = slots[next];
+        if (entry.account == NO_ACCOUNT) {
+            break;
+        }
+        size_t home = homeSlot(entry.id);
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            slots[slot] = entry;
+            slot = next;
+        }
+    }
+    slots[slot] = Entry{0, NO_ACCOUNT};
+    count--;
+    return true;
+}
+
+void TransactionIndex::reserve(size_t capacity) {
+    if (capacity * 2 > slots.size()) {
+        rehash(capacity);
+    }
+}
+
+void TransactionIndex::clear() {
+    slots = vector<Entry>();
+    count = 0;
+    slotBits = 0;
+}
+
+// Lookup
+int TransactionIndex::find(int id) const {
+    size_t slot = findSlot(id);
+    return slot == slots.size() ? NO_ACCOUNT : slots[slot].account;
+}
+
+// Statistics
+size_t TransactionIndex::size() const {
+    return count;
+}
+
+size_t TransactionIndex::memoryBytes() const {
+    return slots.capacity() * sizeof(Entry);
+}
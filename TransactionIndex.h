@@ -0,0 +1,145 @@
+/*-- TransactionIndex.h ------------------------------------------------------
+
+  This header file defines the TransactionIndex class, a flat hash map from
+  transaction IDs to the numbers of the accounts holding them.
+
+  A ForestTree keeps one per lock stripe so that a transaction can be found
+  or removed by its ID alone, and so that an ID already used by any account
+  is rejected when posted. Entries are (ID, account) pairs stored inline in
+  one power-of-two array, placed by a multiplicative hash of the ID, probed
+  linearly and kept at most half full. Removal shifts the rest of a probe
+  run back instead of leaving tombstones. Account numbers are positive, so
+  an account of NO_ACCOUNT marks a free slot and every ID can be a key.
+
+  Basic operations include:
+     - Modification: Insert, remove, reserve, clear
+     - Lookup: Account holding an ID in O(1) average time
+     - Statistics: Entry count and heap memory
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class TransactionIndex {
+private:
+    /******** Data Members ********/
+    struct Entry {
+        int id;        // Transaction ID
+        int account;   // Account holding it, or NO_ACCOUNT if the slot is free
+    };
+
+    vector<Entry> slots;   // Size is 0 or a power of two
+    size_t count;          // Entries in use
+    int slotBits;          // log2(slots.size())
+
+    /******** Private Member Functions ********/
+    size_t homeSlot(int id) const;
+    /*----------------------------------------------------------------------
+    Find where the probe for an ID starts.
+
+    Precondition:  slots is not empty.
+    Postcondition: Returns a slot derived from a multiplicative hash of id.
+    -----------------------------------------------------------------------*/
+
+    size_t findSlot(int id) const;
+    /*----------------------------------------------------------------------
+    Find the slot holding an ID.
+
+    Precondition:  None.
+    Postcondition: Returns the slot whose entry has id, or slots.size() if
+    id is not present.
+    -----------------------------------------------------------------------*/
+
+    void rehash(size_t capacity);
+    /*----------------------------------------------------------------------
+    Resize the table.
+
+    Precondition:  capacity >= count.
+    Postcondition: The table has room for capacity entries at most half
+    full and holds every entry it held before.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constants ********/
+    static const int NO_ACCOUNT = 0;   // Result of find for a missing ID
+
+    /******** Constructors ********/
+    TransactionIndex();
+    /*----------------------------------------------------------------------
+    Construct an empty index.
+
+    Precondition:  None.
+    Postcondition: The index is empty and allocates nothing.
+    -----------------------------------------------------------------------*/
+
+    /******** Modification ********/
+    bool insert(int id, int account);
+    /*----------------------------------------------------------------------
+    Record the account holding an ID.
+
+    Precondition:  account is positive.
+    Postcondition: If the ID is new, it maps to account and true is
+    returned; otherwise nothing changes and false is returned. O(1)
+    average time.
+    -----------------------------------------------------------------------*/
+
+    bool erase(int id, int account);
+    /*----------------------------------------------------------------------
+    Forget an ID held by an account.
+
+    Precondition:  None.
+    Postcondition: If the ID maps to account, its entry is removed and
+    true is returned; otherwise nothing changes and false is returned.
+    O(1) average time.
+    -----------------------------------------------------------------------*/
+
+    void reserve(size_t capacity);
+    /*----------------------------------------------------------------------
+    Prepare for a number of entries.
+
+    Precondition:  None.
+    Postcondition: Inserting up to capacity entries in total does not
+    resize the table.
+    -----------------------------------------------------------------------*/
+
+    void clear();
+    /*----------------------------------------------------------------------
+    Remove every entry.
+
+    Precondition:  None.
+    Postcondition: The index is empty and its memory is freed.
+    -----------------------------------------------------------------------*/
+
+    /******** Lookup ********/
+    int find(int id) const;
+    /*----------------------------------------------------------------------
+    Find the account holding an ID.
+
+    Precondition:  None.
+    Postcondition: Returns the account number id maps to, or NO_ACCOUNT.
+    O(1) average time.
+    -----------------------------------------------------------------------*/
+
+    /******** Statistics ********/
+    size_t size() const;
+    /*----------------------------------------------------------------------
+    Get the number of entries.
+
+    Precondition:  None.
+    Postcondition: Returns the number of IDs indexed.
+    -----------------------------------------------------------------------*/
+
+    size_t memoryBytes() const;
+    /*----------------------------------------------------------------------
+    Get the heap memory held.
+
+    Precondition:  None.
+    Postcondition: Returns the bytes reserved by the table.
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,285 @@
+#include "TransactionStore.h"
+#include <algorithm>
+
+const uint32_t TransactionStore::EMPTY_SLOT;
+const size_t TransactionStore::npos;
+
+// Constructor
+TransactionStore::TransactionStore() : slotBits(0), sorted(true) {}
+
+// Iteration
+TransactionStore::const_iterator TransactionStore::begin() const {
+    return const_iterator(this, 0);
+}
+
+TransactionStore::const_iterator TransactionStore::end() const {
+    return const_iterator(this, ids.size());
+}
+
+// ID index
+size_t TransactionStore::homeSlot(int id) const {
+    // Fibonacci hashing: the top bits of the product are well mixed
+    return (size_t)(((uint64_t)(uint32_t)id * 0x9E3779B97F4A7C15ull) >> (64 - slotBits));
+}
+
+size_t TransactionStore::findSlot(int id) const {
+    if (slots.empty()) {
+        return 0;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t slot = homeSlot(id); ; slot = (slot + 1) & mask) {
+        uint32_t pos = slots[slot];
+        if (pos == EMPTY_SLOT) {
+            return slots.size();
+        }
+        if (ids[pos] == id) {
+            return slot;
+        }
+    }
+}
+
+void TransactionStore::insertSlot(uint32_t pos) {
+    size_t mask = slots.size() - 1;
+    size_t slot = homeSlot(ids[pos]);
+    while (slots[slot] != EMPTY_SLOT) {
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = pos;
+}
+
+void TransactionStore::eraseSlot(size_t slot) {
+    size_t mask = slots.size() - 1;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        uint32_t pos = slots[next];
+        if (pos == EMPTY_SLOT) {
+            break;
+        }
+        // Move the entry back unless its probe starts after the gap
+        size_t home = homeSlot(ids[pos]);
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            slots[slot] = pos;
+            slot = next;
+        }
+    }
+    slots[slot] = EMPTY_SLOT;
+}
+
+void TransactionStore::rebuildIndex(size_t capacity) {
+    if (capacity == 0) {
+        slots = vector<uint32_t>();
+        slotBits = 0;
+        return;
+    }
+    slotBits = 3;
+    while (((size_t)1 << slotBits) < capacity * 2) {
+        slotBits++;
+    }
+    slots.assign((size_t)1 << slotBits, EMPTY_SLOT);
+    for (size_t pos = 0; pos < ids.size(); pos++) {
+        insertSlot(pos);
+    }
+}
+
+// Modification
+bool TransactionStore::add(const Transaction & transaction) {
+    int id = transaction.getId();
+    if (contains(id)) {
+        return false;
+    }
+    size_t pos = ids.size();
+    if (!ids.empty() && ids.back() > id) {
+        sorted = false;
+    }
+    ids.push_back(id);
+    amountCents.push_back(transaction.getAmount().getCents());
+    dates.push_back(transaction.getDate());
+    if (pos % 64 == 0) {
+        creditBits.push_back(0);
+    }
+    if (transaction.getType() == 'C') {
+        creditBits[pos / 64] |= (uint64_t)1 << (pos % 64);
+    }
+
+    if ((pos + 1) * 2 > slots.size()) {
+        rebuildIndex(max(pos + 1, slots.size()));
+    } else {
+        insertSlot(pos);
+    }
+    return true;
+}
+
+bool TransactionStore::erase(int id, Transaction & removed) {
+    size_t slot = findSlot(id);
+    if (slot == slots.size()) {
+        return false;
+    }
+    size_t pos = slots[slot];
+    removed = at(pos);
+    eraseSlot(slot);
+
+    // Move the last transaction into the freed position
+    size_t last = ids.size() - 1;
+    if (pos != last) {
+        slots[findSlot(ids[last])] = pos;
+        ids[pos] = ids[last];
+        amountCents[pos] = amountCents[last];
+        dates[pos] = dates[last];
+        uint64_t bit = (uint64_t)1 << (pos % 64);
+        creditBits[pos / 64] = isCredit(last) ? creditBits[pos / 64] | bit : creditBits[pos / 64] & ~bit;
+        sorted = false;
+    }
+    ids.pop_back();
+    amountCents.pop_back();
+    dates.pop_back();
+    creditBits[last / 64] &= ~((uint64_t)1 << (last % 64));
+    if (last % 64 == 0) {
+        creditBits.pop_back();
+    }
+    if (ids.empty()) {
+        sorted = true;
+    }
+    return true;
+}
+
+void TransactionStore::reserve(size_t count) {
+    ids.reserve(count);
+    amountCents.reserve(count);
+    dates.reserve(count);
+    creditBits.reserve((count + 63) / 64);
+    if (count * 2 > slots.size()) {
+        rebuildIndex(count);
+    }
+}
+
+void TransactionStore::clear() {
+    ids = vector<int>();
+    amountCents = vector<int64_t>();
+    dates = vector<int>();
+    creditBits = vector<uint64_t>();
+    rebuildIndex(0);
+    sorted = true;
+}
+
+// Lookup
+size_t TransactionStore::find(int id) const {
+    size_t slot = findSlot(id);
+    return slot == slots.size() ? npos : slots[slot];
+}
+
+bool TransactionStore::contains(int id) const {
+    return find(id) != npos;
+}
+
+// Access
+size_t TransactionStore::size() const {
+    return ids.size();
+}
+
+bool TransactionStore::empty() const {
+    return ids.empty();
+}
+
+Transaction TransactionStore::at(size_t pos) const {
+    return Transaction(ids[pos], Money::fromCents(amountCents[pos]), isCredit(pos) ? 'C' : 'D', dates[pos]);
+}
+
+int TransactionStore::getId(size_t pos) const {
+    return ids[pos];
+}
+
+int64_t TransactionStore::getAmountCents(size_t pos) const {
+    return amountCents[pos];
+}
+
+int TransactionStore::getDate(size_t pos) const {
+    return dates[pos];
+}
+
+bool TransactionStore::isCredit(size_t pos) const {
+    return (creditBits[pos / 64] >> (pos % 64)) & 1;
+}
+
+const vector<int> &TransactionStore::getIds() const {
+    return ids;
+}
+
+const vector<int64_t> &TransactionStore::getAmountCents() const {
+    return amountCents;
+}
+
+const vector<int> &TransactionStore::getDates() const {
+    return dates;
+}
+
+const vector<uint64_t> &TransactionStore::getCreditBits() const {
+    return creditBits;
+}
+
+size_t TransactionStore::memoryBytes() const {
+    return ids.capacity() * sizeof(int) + amountCents.capacity() * sizeof(int64_t) +
+           dates.capacity() * sizeof(int) + creditBits.capacity() * sizeof(uint64_t) +
+           slots.capacity() * sizeof(uint32_t);
+}
+
+// Kernels
+void TransactionStore::totals(Money & debits, Money & credits, size_t & debitCount) const {
+    totals(0, amountCents.size(), debits, credits, debitCount);
+}
+
+void TransactionStore::totals(size_t first, size_t last, Money & debits, Money & credits,
+                              size_t & debitCount) const {
+    int64_t all = 0, creditCents = 0;
+    size_t creditCount = 0;
+    for (size_t pos = first; pos < last; ) {
+        size_t word = pos / 64;
+        uint64_t bits = creditBits[word] >> (pos % 64);
+        size_t end = min(last, word * 64 + 64);
+        for (; pos < end; pos++, bits >>= 1) {
+            int64_t cents = amountCents[pos];
+            all += cents;
+            creditCents += cents & -(int64_t)(bits & 1);
+            creditCount += bits & 1;
+        }
+    }
+    debits = Money::fromCents(all - creditCents);
+    credits = Money::fromCents(creditCents);
+    debitCount = (last - first) - creditCount;
+}
+
+Money TransactionStore::signedTotal(AuditKernel kernel) const {
+    return Money::fromCents(sumSignedCents(amountCents.data(), creditBits.data(), amountCents.size(), kernel));
+}
+
+void TransactionStore::idRange(int firstId, int lastId, size_t & first, size_t & last) const {
+    first = lower_bound(ids.begin(), ids.end(), firstId) - ids.begin();
+    last = upper_bound(ids.begin() + first, ids.end(), lastId) - ids.begin();
+}
+
+// Sorting
+bool TransactionStore::isSorted() const {
+    return sorted;
+}
+
+void TransactionStore::sort(TransactionSorter & sorter) {
+    if (sorted) {
+        return;
+    }
+    size_t n = ids.size();
+    const vector<uint32_t> & order = sorter.order(ids);
+
+    // The credit bits are rebuilt from the old ones through the order
+    vector<uint64_t> bits(creditBits.size(), 0);
+    for (size_t i = 0; i < n; i++) {
+        if (isCredit(order[i])) {
+            bits[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+    creditBits.swap(bits);
+    sorter.gather(ids);
+    sorter.gather(amountCents);
+    sorter.gather(dates);
+    rebuildIndex(n);
+    sorted = true;
+}
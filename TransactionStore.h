@@ -0,0 +1,298 @@
+/*-- TransactionStore.h ------------------------------------------------------
+
+  This header file defines the TransactionStore class, the columnar list of
+  transactions an Account holds.
+
+  Instead of an array of Transaction objects (24 bytes each, a third of
+  them padding) every field has its own dense column: IDs, amounts in
+  cents, dates, and one bit per transaction that is set for credits. An
+  open-addressing table of 32-bit positions, probed linearly and kept at
+  most half full, maps IDs to positions without a node per entry. Sums and
+  ID-range filters scan only the columns they need, and sorting orders the
+  ID column and then gathers each column once.
+
+  Basic operations include:
+     - Modification: Add, remove (the last transaction fills the gap), clear
+     - Lookup: Position of an ID in O(1) average time
+     - Access: Columns, per-position fields and whole Transaction values
+     - Kernels: Debit/credit totals, ID-range position bounds, radix sort
+     - Iteration: Transaction values in column order
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "Transaction.h"
+#include "RadixSort.h"
+#include "BalanceAudit.h"
+
+using namespace std;
+
+class TransactionStore {
+private:
+    /******** Data Members ********/
+    static const uint32_t EMPTY_SLOT = 0xFFFFFFFFu;   // Marks an unused index slot
+
+    vector<int> ids;                // Transaction IDs
+    vector<int64_t> amountCents;    // Non-negative amounts
+    vector<int> dates;              // Posting dates as yyyymmdd, or 0
+    vector<uint64_t> creditBits;    // Bit i set if transaction i is a credit
+    vector<uint32_t> slots;         // ID index: positions, or EMPTY_SLOT; size is 0 or a power of two
+    int slotBits;                   // log2(slots.size())
+    bool sorted;                    // True while ids is ascending
+
+    /******** Private Member Functions ********/
+    size_t homeSlot(int id) const;
+    /*----------------------------------------------------------------------
+    Find where the probe for an ID starts.
+
+    Precondition:  slots is not empty.
+    Postcondition: Returns a slot derived from a multiplicative hash of id.
+    -----------------------------------------------------------------------*/
+
+    size_t findSlot(int id) const;
+    /*----------------------------------------------------------------------
+    Find the index slot holding an ID.
+
+    Precondition:  None.
+    Postcondition: Returns the slot whose position holds id, or
+    slots.size() if id is not present.
+    -----------------------------------------------------------------------*/
+
+    void insertSlot(uint32_t pos);
+    /*----------------------------------------------------------------------
+    Index the transaction at a position.
+
+    Precondition:  ids[pos] is not indexed, and the table has a free slot.
+    Postcondition: The first free slot of the probe for ids[pos] holds pos.
+    -----------------------------------------------------------------------*/
+
+    void eraseSlot(size_t slot);
+    /*----------------------------------------------------------------------
+    Free an index slot.
+
+    Precondition:  slot holds a position.
+    Postcondition: The slot's entry is removed; later entries of the probe
+    run are shifted back, so every other ID is still found and no
+    tombstones are left.
+    -----------------------------------------------------------------------*/
+
+    void rebuildIndex(size_t capacity);
+    /*----------------------------------------------------------------------
+    Rebuild the ID index.
+
+    Precondition:  None.
+    Postcondition: The table has room for capacity transactions at most
+    half full (no table if capacity is 0) and indexes every position.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constants ********/
+    static const size_t npos = (size_t)-1;   // Result of find for a missing ID
+
+    /******** Iteration ********/
+    class const_iterator {
+    private:
+        const TransactionStore *store;
+        size_t pos;
+
+    public:
+        using iterator_category = input_iterator_tag;
+        using value_type = Transaction;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = Transaction;
+
+        const_iterator(const TransactionStore *store, size_t pos) : store(store), pos(pos) {}
+        Transaction operator*() const { return store->at(pos); }
+        const_iterator &operator++() { pos++; return *this; }
+        bool operator==(const const_iterator &other) const { return pos == other.pos; }
+        bool operator!=(const const_iterator &other) const { return pos != other.pos; }
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    /*----------------------------------------------------------------------
+    Iterate over the transactions.
+
+    Precondition:  None.
+    Postcondition: Yields a Transaction value per position, in column
+    order.
+    -----------------------------------------------------------------------*/
+
+    /******** Constructors ********/
+    TransactionStore();
+    /*----------------------------------------------------------------------
+    Construct an empty store.
+
+    Precondition:  None.
+    Postcondition: The store is empty and sorted, and allocates nothing.
+    -----------------------------------------------------------------------*/
+
+    /******** Modification ********/
+    bool add(const Transaction &transaction);
+    /*----------------------------------------------------------------------
+    Append a transaction.
+
+    Precondition:  The store holds fewer than 2^31 transactions.
+    Postcondition: If the ID is new, the transaction is the last position
+    and true is returned; otherwise nothing changes and false is returned.
+    O(1) average time.
+    -----------------------------------------------------------------------*/
+
+    bool erase(int id, Transaction &removed);
+    /*----------------------------------------------------------------------
+    Remove a transaction by ID.
+
+    Precondition:  None.
+    Postcondition: If the ID is present, the transaction is copied into
+    removed, the last transaction takes its position and true is
+    returned; otherwise nothing changes and false is returned. O(1)
+    average time.
+    -----------------------------------------------------------------------*/
+
+    void reserve(size_t count);
+    /*----------------------------------------------------------------------
+    Prepare for a number of transactions.
+
+    Precondition:  None.
+    Postcondition: Adding up to count transactions in total reallocates
+    neither the columns nor the index.
+    -----------------------------------------------------------------------*/
+
+    void clear();
+    /*----------------------------------------------------------------------
+    Remove every transaction.
+
+    Precondition:  None.
+    Postcondition: The store is empty and sorted, and its memory is freed.
+    -----------------------------------------------------------------------*/
+
+    /******** Lookup ********/
+    size_t find(int id) const;
+    /*----------------------------------------------------------------------
+    Find the position of an ID.
+
+    Precondition:  None.
+    Postcondition: Returns the position holding id, or npos. O(1) average
+    time.
+    -----------------------------------------------------------------------*/
+
+    bool contains(int id) const;
+    /*----------------------------------------------------------------------
+    Check whether an ID is present.
+
+    Precondition:  None.
+    Postcondition: Returns find(id) != npos.
+    -----------------------------------------------------------------------*/
+
+    /******** Access ********/
+    size_t size() const;
+    bool empty() const;
+    /*----------------------------------------------------------------------
+    Get the number of transactions.
+
+    Precondition:  None.
+    Postcondition: Returns the count, or whether it is 0.
+    -----------------------------------------------------------------------*/
+
+    Transaction at(size_t pos) const;
+    /*----------------------------------------------------------------------
+    Get the transaction at a position.
+
+    Precondition:  pos < size().
+    Postcondition: Returns a Transaction built from the columns.
+    -----------------------------------------------------------------------*/
+
+    int getId(size_t pos) const;
+    int64_t getAmountCents(size_t pos) const;
+    int getDate(size_t pos) const;
+    bool isCredit(size_t pos) const;
+    /*----------------------------------------------------------------------
+    Get one field of the transaction at a position.
+
+    Precondition:  pos < size().
+    Postcondition: Returns the field without building a Transaction.
+    -----------------------------------------------------------------------*/
+
+    const vector<int> &getIds() const;
+    const vector<int64_t> &getAmountCents() const;
+    const vector<int> &getDates() const;
+    const vector<uint64_t> &getCreditBits() const;
+    /*----------------------------------------------------------------------
+    Get a whole column; bit i of the credit bits (word i / 64) is set if
+    transaction i is a credit.
+
+    Precondition:  None.
+    Postcondition: Returns a constant reference to the column, in position
+    order.
+    -----------------------------------------------------------------------*/
+
+    size_t memoryBytes() const;
+    /*----------------------------------------------------------------------
+    Get the heap memory held.
+
+    Precondition:  None.
+    Postcondition: Returns the bytes reserved by the columns and the index.
+    -----------------------------------------------------------------------*/
+
+    /******** Kernels ********/
+    void totals(Money &debits, Money &credits, size_t &debitCount) const;
+    /*----------------------------------------------------------------------
+    Sum the debits and credits.
+
+    Precondition:  None.
+    Postcondition: debits and credits hold the totals of each type and
+    debitCount the number of debits, computed in one branch-free pass over
+    the amount column and the credit bits.
+    -----------------------------------------------------------------------*/
+
+    void totals(size_t first, size_t last, Money &debits, Money &credits, size_t &debitCount) const;
+    /*----------------------------------------------------------------------
+    Sum the debits and credits at some positions.
+
+    Precondition:  first <= last <= size().
+    Postcondition: As totals above, over the positions [first, last) only.
+    -----------------------------------------------------------------------*/
+
+    Money signedTotal(AuditKernel kernel = AuditKernel::Vector) const;
+    /*----------------------------------------------------------------------
+    Get the net effect of every transaction on the balance.
+
+    Precondition:  None.
+    Postcondition: Returns debits minus credits, summed by the given
+    kernel (see BalanceAudit.h).
+    -----------------------------------------------------------------------*/
+
+    void idRange(int firstId, int lastId, size_t &first, size_t &last) const;
+    /*----------------------------------------------------------------------
+    Find the positions of an ID range.
+
+    Precondition:  isSorted().
+    Postcondition: [first, last) are the positions whose ID is between
+    firstId and lastId, both included, found by binary search of the ID
+    column.
+    -----------------------------------------------------------------------*/
+
+    /******** Sorting ********/
+    bool isSorted() const;
+    /*----------------------------------------------------------------------
+    Check the order of the columns.
+
+    Precondition:  None.
+    Postcondition: Returns true if the IDs are known to be ascending.
+    -----------------------------------------------------------------------*/
+
+    void sort(TransactionSorter &sorter);
+    /*----------------------------------------------------------------------
+    Put the transactions in ascending ID order.
+
+    Precondition:  None.
+    Postcondition: The ID column is radix sorted, every other column is
+    gathered into the same order and the index is rebuilt. Does nothing if
+    the store is already sorted.
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,819 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Microbenchmarks of the core data structures.
+ *
+ * Usage: chart_bench [--accounts N] [--transactions M] [--skewed] [--dated] [--seed S]
+ *                    [--threads T] [--repeat R] [--filter TEXT]
+ *                    [--format json|csv] [--out FILE] [--dir DIR]
+ *
+ * A synthetic chart and posting stream (see ChartGenerator.h) are generated
+ * into DIR, which also receives every report file, and each benchmark is
+ * run R times. One result line is printed per benchmark: JSON objects, one
+ * per line, or CSV with a header, so runs can be compared by a script.
+ *
+ * The concurrent posting benchmark doubles as a stress test: after every
+ * run the account balances are checked against a sequential computation,
+ * and the program exits with status 1 if any run disagrees.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ChartGenerator.h"
+#include "ForestTree.h"
+#include "RadixSort.h"
+
+using namespace std;
+
+/******** Options ********/
+struct BenchOptions {
+    GeneratorOptions data;        // Chart and posting stream
+    unsigned threads = 0;         // Most threads of the scaling runs (0 = one per core)
+    size_t repeat = 3;            // Runs per benchmark
+    string filter;                // Only benchmarks whose name contains this
+    bool csv = false;             // CSV instead of JSON lines
+    string outFile;               // Results file, or empty for standard output
+    string dir = "bench_data";    // Scratch directory
+};
+
+/******** Results ********/
+struct BenchResult {
+    string name;                  // Benchmark name
+    unsigned threads;             // Threads used
+    size_t items;                 // Operations per run
+    double best;                  // Fastest run, in seconds
+    double mean;                  // Average run, in seconds
+    bool consistent;              // Whether the run's checks passed
+};
+
+class BenchReporter {
+private:
+    ostream &out;
+    const BenchOptions &options;
+
+public:
+    BenchReporter(ostream &out, const BenchOptions &options) : out(out), options(options) {
+        if (options.csv) {
+            out << "benchmark,threads,accounts,transactions,distribution,items,repeat,"
+                   "best_seconds,mean_seconds,items_per_second,consistent\n";
+        }
+    }
+
+    void report(const BenchResult &result) {
+        const char *distribution = options.data.skewed ? "skewed" : "uniform";
+        double rate = result.best > 0 ? result.items / result.best : 0;
+        if (options.csv) {
+            out << result.name << ',' << result.threads << ',' << options.data.accounts << ','
+                << options.data.transactions << ',' << distribution << ',' << result.items << ','
+                << options.repeat << ',' << result.best << ',' << result.mean << ','
+                << rate << ',' << (result.consistent ? "true" : "false") << '\n';
+        } else {
+            out << "{\"benchmark\":\"" << result.name << "\",\"threads\":" << result.threads
+                << ",\"accounts\":" << options.data.accounts
+                << ",\"transactions\":" << options.data.transactions
+                << ",\"distribution\":\"" << distribution << "\",\"items\":" << result.items
+                << ",\"repeat\":" << options.repeat << ",\"best_seconds\":" << result.best
+                << ",\"mean_seconds\":" << result.mean << ",\"items_per_second\":" << rate
+                << ",\"consistent\":" << (result.consistent ? "true" : "false") << "}\n";
+        }
+        out.flush();
+    }
+};
+
+/******** Benchmark Driver ********/
+class BenchSuite {
+private:
+    const BenchOptions &options;
+    BenchReporter &reporter;
+    bool allConsistent = true;
+
+public:
+    BenchSuite(const BenchOptions &options, BenchReporter &reporter)
+     : options(options), reporter(reporter) {}
+
+    bool selected(const string &name) const {
+        return options.filter.empty() || name.find(options.filter) != string::npos;
+    }
+
+    // Runs setup, body and check options.repeat times; only body is timed.
+    // check returns false if the run left wrong results.
+    void run(const string &name, unsigned threads, size_t items, const function<void()> &setup,
+             const function<void()> &body, const function<bool()> &check) {
+        if (!selected(name)) {
+            return;
+        }
+        BenchResult result{name, threads, items, 0, 0, true};
+        double total = 0;
+        for (size_t r = 0; r < options.repeat; r++) {
+            setup();
+            auto start = chrono::steady_clock::now();
+            body();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            result.best = r == 0 ? seconds : min(result.best, seconds);
+            total += seconds;
+            result.consistent = check() && result.consistent;
+        }
+        result.mean = total / options.repeat;
+        allConsistent = allConsistent && result.consistent;
+        reporter.report(result);
+    }
+
+    bool passed() const {
+        return allConsistent;
+    }
+};
+
+// Thread counts of the scaling runs: powers of two up to the maximum, and the maximum
+static vector<unsigned> threadCounts(unsigned maxThreads) {
+    vector<unsigned> counts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// Balance of every account after the postings, computed without the tree
+static unordered_map<int, Money> expectedBalances(const vector<int> &accounts, const ForestTree &loaded,
+                                                  const vector<pair<int, Transaction>> &postings) {
+    unordered_map<int, Money> own;
+    for (const auto &posting : postings) {
+        own[posting.first] += posting.second.getSignedAmount();
+    }
+    unordered_map<int, Money> expected;
+    for (int number : accounts) {
+        Money balance;
+        loaded.getAccountBalance(number, balance);
+        expected[number] += balance;
+        auto it = own.find(number);
+        if (it == own.end()) {
+            continue;
+        }
+        // The account and each of its ancestors (its digit prefixes)
+        for (int prefix = number; prefix > 0; prefix /= 10) {
+            expected[prefix] += it->second;
+        }
+    }
+    return expected;
+}
+
+static bool balancesMatch(const ForestTree &tree, const unordered_map<int, Money> &expected) {
+    for (const auto &entry : expected) {
+        Money balance;
+        if (!tree.getAccountBalance(entry.first, balance) || balance != entry.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One pass of the base-10 counting sort that TransactionSorter replaced,
+// kept as it was so the sorts can be compared
+static void countingSortByDigit(vector<Transaction> &transactions, int exp) {
+    int n = transactions.size();
+    vector<Transaction> output(n);
+    int count[10] = {0};
+
+    // Count occurrences of digits in the current position
+    for (int i = 0; i < n; i++) {
+        int digit = (transactions[i].getId() / exp) % 10;
+        count[digit]++;
+    }
+
+    // Update count[i] to hold the actual position of digits
+    for (int i = 1; i < 10; i++) {
+        count[i] += count[i - 1];
+    }
+
+    // Build the output array
+    for (int i = n - 1; i >= 0; i--) {
+        int digit = (transactions[i].getId() / exp) % 10;
+        output[count[digit] - 1] = transactions[i];
+        count[digit]--;
+    }
+
+    // Copy the sorted transactions back to the original vector
+    for (int i = 0; i < n; i++) {
+        transactions[i] = output[i];
+    }
+}
+
+static void countingSortTransactions(vector<Transaction> &transactions) {
+    // Find the maximum transaction ID
+    int maxId = 0;
+    for (const auto &trans : transactions) {
+        maxId = max(maxId, trans.getId());
+    }
+
+    // Perform counting sort for each digit
+    for (int exp = 1; maxId / exp > 0; exp *= 10) {
+        countingSortByDigit(transactions, exp);
+    }
+}
+
+static bool parseCount(const char *text, size_t &value) {
+    try {
+        size_t end;
+        value = stoull(text, &end);
+        return text[end] == '\0';
+    } catch (const exception &) {
+        return false;
+    }
+}
+
+static bool parseOptions(int argc, char *argv[], BenchOptions &options) {
+    options.data.transactions = 1000000;
+    options.data.accounts = 100000;
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        size_t value = 0;
+        if (option == "--skewed") {
+            options.data.skewed = true;
+            continue;
+        }
+        if (option == "--dated") {
+            options.data.dated = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *text = argv[++i];
+        if (option == "--accounts") {
+            if (!parseCount(text, options.data.accounts) || options.data.accounts < 1 ||
+                options.data.accounts > 2147483647) {
+                return false;
+            }
+        } else if (option == "--transactions") {
+            if (!parseCount(text, options.data.transactions) || options.data.transactions > 2147483647) {
+                return false;
+            }
+        } else if (option == "--seed") {
+            if (!parseCount(text, value)) {
+                return false;
+            }
+            options.data.seed = value;
+        } else if (option == "--threads") {
+            if (!parseCount(text, value) || value > 1024) {
+                return false;
+            }
+            options.threads = (unsigned)value;
+        } else if (option == "--repeat") {
+            if (!parseCount(text, options.repeat) || options.repeat < 1) {
+                return false;
+            }
+        } else if (option == "--filter") {
+            options.filter = text;
+        } else if (option == "--format") {
+            if (string(text) != "json" && string(text) != "csv") {
+                return false;
+            }
+            options.csv = string(text) == "csv";
+        } else if (option == "--out") {
+            options.outFile = text;
+        } else if (option == "--dir") {
+            options.dir = text;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        cerr << "Usage: " << argv[0] << " [--accounts N] [--transactions M] [--skewed] [--dated]"
+             << " [--seed S] [--threads T] [--repeat R] [--filter TEXT] [--format json|csv] [--out FILE]"
+             << " [--dir DIR]\n";
+        return 2;
+    }
+    unsigned maxThreads = options.threads != 0 ? options.threads : max(1u, thread::hardware_concurrency());
+
+    ofstream resultFile;
+    if (!options.outFile.empty()) {
+        resultFile.open(options.outFile);
+        if (!resultFile) {
+            cerr << "Error: Could not open " << options.outFile << endl;
+            return 1;
+        }
+    }
+    BenchReporter reporter(options.outFile.empty() ? cout : resultFile, options);
+    BenchSuite suite(options, reporter);
+
+    // Reports are written relative to the working directory
+    filesystem::create_directories(options.dir);
+    filesystem::current_path(options.dir);
+    filesystem::create_directories("Print_results");
+    filesystem::create_directories("Extra_features");
+
+    // Input data
+    ChartGenerator generator(options.data);
+    const string chartFile = "chart.txt";
+    {
+        ofstream chart(chartFile, ios::binary);
+        generator.writeChart(chart);
+    }
+    vector<int> accounts = generator.accountNumbers();
+    vector<pair<int, Transaction>> postings = generator.postings(options.data.transactions);
+
+    ForestTree loaded;
+    if (!loaded.buildTreeFromFile(chartFile)) {
+        cerr << "Error: Could not load the generated chart" << endl;
+        return 1;
+    }
+    unordered_map<int, Money> loadedBalances = expectedBalances(accounts, loaded, {});
+    unordered_map<int, Money> expected = expectedBalances(accounts, loaded, postings);
+
+    // Accounts drawn like postings, for lookups
+    vector<int> probes;
+    probes.reserve(postings.size());
+    for (const auto &posting : postings) {
+        probes.push_back(posting.first);
+    }
+
+    /******** Building ********/
+    auto none = [] {};
+    auto always = [] { return true; };
+    unique_ptr<ForestTree> tree;
+    auto freshTree = [&] { tree = make_unique<ForestTree>(); };
+    auto loadedTree = [&] {
+        tree = make_unique<ForestTree>();
+        tree->buildTreeFromFile(chartFile);
+    };
+    auto treeBalancesMatch = [&] { return balancesMatch(*tree, expected); };
+
+    suite.run("buildTreeFromFile", 1, accounts.size(), freshTree, [&] {
+        tree->buildTreeFromFile(chartFile);
+    }, [&] { return balancesMatch(*tree, loadedBalances); });
+
+    suite.run("addAccount/preorder", 1, accounts.size(), freshTree, [&] {
+        for (int number : accounts) {
+            tree->addAccount(number, "Account", Money());
+        }
+    }, always);
+
+    // Top-level accounts first; the rest in random order
+    vector<int> shuffled(accounts);
+    stable_partition(shuffled.begin(), shuffled.end(), [](int n) { return n < 10; });
+    size_t topLevel = min<size_t>(9, shuffled.size());
+    shuffle(shuffled.begin() + topLevel, shuffled.end(), mt19937_64(options.data.seed));
+    suite.run("addAccount/shuffled", 1, accounts.size(), freshTree, [&] {
+        for (int number : shuffled) {
+            tree->addAccount(number, "Account", Money());
+        }
+    }, always);
+
+    /******** Lookups ********/
+    size_t found = 0;
+    auto foundAll = [&] { return found == probes.size(); };
+    suite.run("searchAccountWithTracking", 1, probes.size(), [&] { found = 0; }, [&] {
+        for (int number : probes) {
+            found += loaded.searchAccountWithTracking(number)[0] != nullptr;
+        }
+    }, foundAll);
+
+    suite.run("getAccountBalance", 1, probes.size(), [&] { found = 0; }, [&] {
+        Money balance;
+        for (int number : probes) {
+            found += loaded.getAccountBalance(number, balance);
+        }
+    }, foundAll);
+
+    /******** Posting ********/
+    suite.run("addAcountTransaction", 1, postings.size(), loadedTree, [&] {
+        for (const auto &posting : postings) {
+            tree->addAcountTransaction(posting.first, posting.second);
+        }
+    }, treeBalancesMatch);
+
+    suite.run("addAcountTransaction/lazy", 1, postings.size(), [&] {
+        loadedTree();
+        tree->setLazyBalances(true);
+    }, [&] {
+        for (const auto &posting : postings) {
+            tree->addAcountTransaction(posting.first, posting.second);
+        }
+    }, treeBalancesMatch);
+
+    const size_t batchSize = 1 << 16;
+    suite.run("postBatch", 1, postings.size(), loadedTree, [&] {
+        for (size_t start = 0; start < postings.size(); start += batchSize) {
+            vector<pair<int, Transaction>> batch(postings.begin() + start,
+                                                 postings.begin() + min(postings.size(), start + batchSize));
+            tree->postBatch(batch);
+        }
+    }, treeBalancesMatch);
+
+    // Concurrent posting; the balance check makes this the stress test
+    for (unsigned threads : threadCounts(maxThreads)) {
+        suite.run("addAcountTransaction/concurrent", threads, postings.size(), [&] {
+            loadedTree();
+            tree->setConcurrent(true);
+        }, [&] {
+            vector<thread> workers;
+            for (unsigned t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    for (size_t i = t; i < postings.size(); i += threads) {
+                        tree->addAcountTransaction(postings[i].first, postings[i].second);
+                    }
+                });
+            }
+            for (thread &worker : workers) {
+                worker.join();
+            }
+        }, treeBalancesMatch);
+    }
+
+    /******** Transaction Lists ********/
+    // One account holding every posting, added in random ID order
+    vector<Transaction> history;
+    history.reserve(postings.size());
+    for (const auto &posting : postings) {
+        history.push_back(posting.second);
+    }
+    shuffle(history.begin(), history.end(), mt19937_64(options.data.seed + 1));
+    Account unsorted(1, "History", Money());
+    for (const Transaction &t : history) {
+        unsorted.addTransaction(t);
+    }
+
+    Account account;
+    auto copyUnsorted = [&] { account = unsorted; };
+    suite.run("findTransaction", 1, history.size(), [&] {
+        copyUnsorted();
+        found = 0;
+    }, [&] {
+        Transaction copy;
+        for (const Transaction &t : history) {
+            found += account.findTransaction(t.getId(), copy);
+        }
+    }, [&] { return found == history.size(); });
+
+    suite.run("radixSortTransactions", 1, history.size(), copyUnsorted, [&] {
+        account.radixSortTransactions();
+    }, [&] {
+        const vector<int> &ids = account.getTransactions().getIds();
+        return ids.size() == history.size() && is_sorted(ids.begin(), ids.end());
+    });
+
+    // The three sorts on the same shuffled transactions, at fixed sizes
+    TransactionSorter sorter;
+    for (size_t n : {(size_t)1000, (size_t)100000, (size_t)10000000}) {
+        string radixName = "sortTransactions/radix/" + to_string(n);
+        string stdName = "sortTransactions/std/" + to_string(n);
+        string countingName = "sortTransactions/counting10/" + to_string(n);
+        if (!suite.selected(radixName) && !suite.selected(stdName) && !suite.selected(countingName)) {
+            continue;
+        }
+        vector<Transaction> shuffled;
+        shuffled.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            shuffled.push_back(Transaction((int)i + 1, Money::fromCents(i % 10000 + 1), i % 3 ? 'D' : 'C'));
+        }
+        shuffle(shuffled.begin(), shuffled.end(), mt19937_64(options.data.seed + 2));
+        vector<Transaction> sorting;
+        auto copyShuffled = [&] { sorting = shuffled; };
+        auto sortedById = [&] {
+            return sorting.size() == n && is_sorted(sorting.begin(), sorting.end(),
+                [](const Transaction &a, const Transaction &b) { return a.getId() < b.getId(); });
+        };
+
+        suite.run(radixName, 1, n, copyShuffled, [&] {
+            vector<int> ids;
+            ids.reserve(sorting.size());
+            for (const Transaction &t : sorting) {
+                ids.push_back(t.getId());
+            }
+            sorter.order(ids);
+            sorter.gather(sorting);
+        }, sortedById);
+
+        suite.run(stdName, 1, n, copyShuffled, [&] {
+            sort(sorting.begin(), sorting.end(), [](const Transaction &a, const Transaction &b) {
+                return a.getId() < b.getId();
+            });
+        }, sortedById);
+
+        suite.run(countingName, 1, n, copyShuffled, [&] {
+            countingSortTransactions(sorting);
+        }, sortedById);
+    }
+
+    Money expectedNet;
+    for (const Transaction &t : history) {
+        expectedNet += t.getSignedAmount();
+    }
+    Money net;
+    suite.run("transactionTotals", 1, history.size(), [&] {
+        copyUnsorted();
+        account.radixSortTransactions();
+    }, [&] {
+        net = account.getTransactions().signedTotal();
+    }, [&] { return net == expectedNet; });
+
+    // The same sum straight from the columns, per kernel
+    for (AuditKernel kernel : {AuditKernel::Scalar, AuditKernel::Vector}) {
+        int64_t cents = 0;
+        suite.run(kernel == AuditKernel::Scalar ? "sumSignedCents/scalar" : "sumSignedCents/vector", 1,
+                  history.size(), [&] {
+            copyUnsorted();
+            account.radixSortTransactions();
+        }, [&] {
+            const TransactionStore &store = account.getTransactions();
+            cents = sumSignedCents(store.getAmountCents().data(), store.getCreditBits().data(), store.size(), kernel);
+        }, [&] { return cents == expectedNet.getCents(); });
+    }
+
+    /******** Reports ********/
+    ForestTree posted;
+    posted.buildTreeFromFile(chartFile);
+    posted.postBatch(postings);
+    size_t reportItems = accounts.size() + postings.size();
+    bool written = false;
+    auto wasWritten = [&] { return written; };
+
+    suite.run("printTreeIntoFile", 1, accounts.size(), none, [&] {
+        written = posted.printTreeIntoFile("tree.txt");
+    }, wasWritten);
+
+    for (unsigned threads : threadCounts(maxThreads)) {
+        suite.run("fullReport", threads, reportItems, [&] { posted.setReportThreads(threads); }, [&] {
+            ofstream out("Extra_features/full.txt");
+            out << posted;
+            written = out.good();
+        }, wasWritten);
+    }
+
+    suite.run("printAccount", 1, reportItems, none, [&] {
+        written = true;
+        for (int top = 1; top <= 9 && top <= (int)accounts.size(); top++) {
+            written = posted.printAccount(top) == Status::Ok && written;
+        }
+    }, wasWritten);
+
+    // Every report is its own file, so the export is capped
+    vector<int> exported(accounts.begin(), accounts.begin() + min<size_t>(accounts.size(), 10000));
+    for (unsigned threads : threadCounts(maxThreads)) {
+        suite.run("exportAccountReports", threads, exported.size(), [&] { posted.setReportThreads(threads); }, [&] {
+            written = posted.exportAccountReports(exported) == exported.size();
+        }, wasWritten);
+    }
+    posted.setReportThreads(1);
+
+    /******** Flattened Snapshot ********/
+    ForestSnapshot flat = posted.snapshot();
+    suite.run("snapshot/build", 1, reportItems, none, [&] {
+        flat = posted.snapshot();
+    }, [&] { return flat.size() == accounts.size(); });
+
+    // The same walk over every account: node links against the preorder columns
+    BalanceSummary viaTree, viaSnapshot;
+    suite.run("traverse/pointerTree", 1, accounts.size(), none, [&] {
+        viaTree = BalanceSummary();
+        BalanceSummary top;
+        for (int prefix = 1; prefix <= 9; prefix++) {
+            if (!posted.summarizeAccounts(prefix, top)) {
+                continue;
+            }
+            if (viaTree.accounts == 0 || top.minBalance < viaTree.minBalance) {
+                viaTree.minBalance = top.minBalance;
+                viaTree.minAccount = top.minAccount;
+            }
+            if (viaTree.accounts == 0 || top.maxBalance > viaTree.maxBalance) {
+                viaTree.maxBalance = top.maxBalance;
+                viaTree.maxAccount = top.maxAccount;
+            }
+            viaTree.accounts += top.accounts;
+            viaTree.total += top.total;
+        }
+    }, [&] { return viaTree.accounts == accounts.size(); });
+
+    suite.run("traverse/snapshot", 1, accounts.size(), none, [&] {
+        viaSnapshot = BalanceSummary();
+        for (size_t pos = 0; pos < flat.size(); pos++) {
+            Money balance = flat.getBalance(pos);
+            if (viaSnapshot.accounts == 0 || balance < viaSnapshot.minBalance) {
+                viaSnapshot.minBalance = balance;
+                viaSnapshot.minAccount = flat.getAccountNumber(pos);
+            }
+            if (viaSnapshot.accounts == 0 || balance > viaSnapshot.maxBalance) {
+                viaSnapshot.maxBalance = balance;
+                viaSnapshot.maxAccount = flat.getAccountNumber(pos);
+            }
+            if (flat.getDepth(pos) == 0) {
+                viaSnapshot.total += balance;
+            }
+            viaSnapshot.accounts++;
+        }
+    }, [&] {
+        // Both walks see the same accounts when both ran
+        return viaSnapshot.accounts == accounts.size() &&
+               (viaTree.accounts == 0 ||
+                (viaTree.total == viaSnapshot.total && viaTree.minAccount == viaSnapshot.minAccount &&
+                 viaTree.maxAccount == viaSnapshot.maxAccount));
+    });
+
+    string expectedReport, printedReport;
+    if (suite.selected("snapshot/print")) {
+        ostringstream report;
+        report << posted;
+        expectedReport = report.str();
+    }
+    suite.run("snapshot/print", 1, reportItems, none, [&] {
+        ostringstream report;
+        flat.print(report);
+        printedReport = report.str();
+    }, [&] { return printedReport == expectedReport; });
+
+    /******** Subtree Queries ********/
+    // Prefixes one level above the probed accounts
+    vector<int> prefixes;
+    for (size_t i = 0; i < probes.size() && i < 100000; i++) {
+        prefixes.push_back(probes[i] < 10 ? probes[i] : probes[i] / 10);
+    }
+    // Queries read the live tree, so a change just before one costs nothing extra
+    int nextQueryId = (int)postings.size() + 1;
+    size_t interleaved = min<size_t>(prefixes.size(), 1000);
+    bool agreed = false;
+    suite.run("summarizeAccounts/afterChange", 1, interleaved, none, [&] {
+        BalanceSummary summary;
+        agreed = true;
+        for (size_t i = 0; i < interleaved; i++) {
+            // A change that leaves the balances as they were
+            posted.addAcountTransaction(1, Transaction(nextQueryId, Money::fromCents(1), 'D'));
+            posted.removeAccountTransaction(1, nextQueryId++);
+            agreed = posted.summarizeAccounts(prefixes[i], summary) && agreed;
+        }
+    }, [&] {
+        // A prefix that is an account totals to that account's balance
+        BalanceSummary summary;
+        Money balance;
+        return agreed && posted.summarizeAccounts(1, summary) && posted.getAccountBalance(1, balance) &&
+               summary.total == balance;
+    });
+
+    size_t answered = 0;
+    auto answeredAll = [&] { return answered == prefixes.size(); };
+    suite.run("summarizeAccounts", 1, prefixes.size(), [&] { answered = 0; }, [&] {
+        BalanceSummary summary;
+        for (int prefix : prefixes) {
+            answered += posted.summarizeAccounts(prefix, summary);
+        }
+    }, answeredAll);
+
+    suite.run("topAccounts", 1, prefixes.size(), [&] { answered = 0; }, [&] {
+        for (int prefix : prefixes) {
+            answered += !posted.topAccounts(prefix, 10).empty();
+        }
+    }, answeredAll);
+
+    int lastId = (int)postings.size() / 2;
+    suite.run("splitTransactions", 1, prefixes.size(), [&] { answered = 0; }, [&] {
+        for (int prefix : prefixes) {
+            TransactionSplit split = posted.splitTransactions(prefix, 1, lastId);
+            answered += split.debitCount + split.creditCount <= (size_t)lastId;
+        }
+    }, answeredAll);
+
+    /******** Balance History ********/
+    // Dates spread over 2024; only --dated postings reach the histories
+    vector<int> probeDates;
+    probeDates.reserve(probes.size());
+    for (size_t i = 0; i < probes.size(); i++) {
+        probeDates.push_back(20240000 + (int)(i % 12 + 1) * 100 + (int)(i % 28 + 1));
+    }
+    suite.run("getBalanceAsOf", 1, probes.size(), [&] { answered = 0; }, [&] {
+        Money balance;
+        for (size_t i = 0; i < probes.size(); i++) {
+            answered += posted.getBalanceAsOf(probes[i], probeDates[i], balance) == Status::Ok;
+        }
+    }, [&] {
+        // At the end of the year every posting has happened
+        Money asOf, current;
+        for (int top = 1; top <= 9 && top <= (int)accounts.size(); top++) {
+            if (posted.getBalanceAsOf(top, 20241231, asOf) != Status::Ok ||
+                !posted.getAccountBalance(top, current) || asOf != current) {
+                return false;
+            }
+        }
+        return answered == probes.size();
+    });
+
+    /******** Transaction Index ********/
+    // Every posting found by its ID alone, in random order
+    suite.run("findTransaction/global", 1, history.size(), [&] { found = 0; }, [&] {
+        int owner;
+        Transaction copy;
+        for (const Transaction &t : history) {
+            found += posted.findTransaction(t.getId(), owner, copy) == Status::Ok;
+        }
+    }, [&] { return found == history.size(); });
+
+    /******** Balance Audit ********/
+    for (AuditKernel kernel : {AuditKernel::Scalar, AuditKernel::Vector}) {
+        AuditReport report;
+        suite.run(kernel == AuditKernel::Scalar ? "balanceAudit/scalar" : "balanceAudit/vector", 1, reportItems,
+                  none, [&] {
+            report = posted.auditBalances(kernel);
+        }, [&] { return report.passed() && report.accounts == accounts.size(); });
+    }
+
+    suite.run("saveSnapshot", 1, reportItems, none, [&] {
+        written = posted.saveSnapshot("snapshot.bin");
+    }, wasWritten);
+
+    // The loads below read the file themselves, whatever the filter
+    if (suite.selected("loadSnapshot")) {
+        posted.saveSnapshot("snapshot.bin");
+    }
+    Status restored = Status::Ok;
+    string savedReport;
+    suite.run("loadSnapshot", 1, reportItems, freshTree, [&] {
+        restored = tree->loadSnapshot("snapshot.bin");
+    }, [&] {
+        // The restored tree exports exactly what the saved one does
+        if (savedReport.empty()) {
+            ostringstream report;
+            report << posted;
+            savedReport = report.str();
+        }
+        ostringstream report;
+        report << *tree;
+        return restored == Status::Ok && treeBalancesMatch() && report.str() == savedReport;
+    });
+
+    // Damaged copies of the snapshot, each with the status it must be rejected with
+    vector<pair<string, Status>> damaged;
+    if (suite.selected("loadSnapshot/rejected")) {
+        ifstream in("snapshot.bin", ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        SnapshotHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        size_t accountsAt = sizeof(header);
+        size_t transactionsAt = accountsAt + header.accountCount * sizeof(SnapshotAccount);
+        auto writeCopy = [&](const string &name, Status status, const function<void(string &)> &damage,
+                             bool resum) {
+            string copy = bytes;
+            damage(copy);
+            if (resum) {
+                SnapshotHeader copyHeader;
+                memcpy(&copyHeader, copy.data(), sizeof(copyHeader));
+                copyHeader.checksum = snapshotChecksum(copy.data() + sizeof(copyHeader), copy.size() - sizeof(copyHeader));
+                memcpy(&copy[0], &copyHeader, sizeof(copyHeader));
+            }
+            ofstream(name, ios::binary) << copy;
+            damaged.push_back({name, status});
+        };
+        damaged.push_back({"missing.bin", Status::FileError});
+        writeCopy("version.bin", Status::VersionMismatch, [&](string &copy) {
+            copy[offsetof(SnapshotHeader, version)]++;
+        }, false);
+        writeCopy("checksum.bin", Status::ChecksumMismatch, [&](string &copy) {
+            copy.back() ^= 1;
+        }, false);
+        if (header.accountCount >= 2) {
+            // The second account takes the number of the first
+            writeCopy("account.bin", Status::AccountExists, [&](string &copy) {
+                memcpy(&copy[accountsAt + sizeof(SnapshotAccount)], &copy[accountsAt], sizeof(int32_t));
+            }, true);
+        }
+        if (header.transactionCount >= 2) {
+            // The second transaction takes the ID of the first
+            writeCopy("transaction.bin", Status::TransactionExists, [&](string &copy) {
+                memcpy(&copy[transactionsAt + sizeof(SnapshotTransaction)], &copy[transactionsAt], sizeof(int32_t));
+            }, true);
+        }
+        filesystem::remove("missing.bin");
+    }
+    vector<Status> rejections;
+    suite.run("loadSnapshot/rejected", 1, damaged.size(), [&] {
+        loadedTree();
+        rejections.clear();
+    }, [&] {
+        for (const auto &file : damaged) {
+            rejections.push_back(tree->loadSnapshot(file.first));
+        }
+    }, [&] {
+        // Every cause is told apart, and the tree is left as it was
+        for (size_t i = 0; i < damaged.size(); i++) {
+            if (rejections[i] != damaged[i].second) {
+                return false;
+            }
+        }
+        return balancesMatch(*tree, loadedBalances);
+    });
+
+    return suite.passed() ? 0 : 1;
+}
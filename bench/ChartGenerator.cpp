@@ -0,0 +1,106 @@
+#include "ChartGenerator.h"
+#include <cmath>
+#include <numeric>
+#include "OutputBuffer.h"
+
+ChartGenerator::ChartGenerator(const GeneratorOptions & options)
+ : options(options), random(options.seed), scatter(2654435761u % options.accounts | 1), nextId(1) {
+    // Multiplying by a number coprime to the chart size permutes the ranks
+    while (gcd(scatter, (uint64_t)options.accounts) != 1) {
+        scatter += 2;
+    }
+}
+
+uint64_t ChartGenerator::below(uint64_t bound) {
+    // Lemire's multiply-shift reduction; the bias is negligible for our bounds
+    return (uint64_t)(((unsigned __int128)random() * bound) >> 64);
+}
+
+void ChartGenerator::appendPreorder(int number, vector<int> & numbers) const {
+    numbers.push_back(number);
+    for (int digit = 0; digit < 10; digit++) {
+        int64_t child = (int64_t)number * 10 + digit;
+        if (child > (int64_t)options.accounts) {
+            return;
+        }
+        appendPreorder((int)child, numbers);
+    }
+}
+
+vector<int> ChartGenerator::accountNumbers() const {
+    vector<int> numbers;
+    numbers.reserve(options.accounts);
+    for (int top = 1; top <= 9 && top <= (int64_t)options.accounts; top++) {
+        appendPreorder(top, numbers);
+    }
+    return numbers;
+}
+
+void ChartGenerator::writeChart(ostream & out) {
+    OutputBuffer buffer(out);
+    for (int number : accountNumbers()) {
+        buffer.writeInt(number);
+        buffer.write(" Account ");
+        buffer.writeInt(number);
+        buffer.put(' ');
+        buffer.writeMoney(Money::fromCents((int64_t)below(10000000)));
+        buffer.put('\n');
+    }
+}
+
+int ChartGenerator::nextAccount() {
+    if (!options.skewed) {
+        return (int)below(options.accounts) + 1;
+    }
+    // Inverse transform of the continuous 1/k density over [1, accounts + 1)
+    double u = (random() >> 11) * 0x1.0p-53;
+    uint64_t rank = (uint64_t)exp(u * log((double)options.accounts + 1));
+    rank = min<uint64_t>(max<uint64_t>(rank, 1), options.accounts);
+    return (int)(rank * scatter % options.accounts) + 1;
+}
+
+Transaction ChartGenerator::nextTransaction() {
+    static const int DAYS_IN_MONTH_2024[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    Money amount = Money::fromCents((int64_t)below(100000) + 1);
+    char type = below(2) == 0 ? 'D' : 'C';
+    int date = 0;
+    if (options.dated) {
+        int day = (int)below(366), month = 0;
+        while (day >= DAYS_IN_MONTH_2024[month]) {
+            day -= DAYS_IN_MONTH_2024[month++];
+        }
+        date = 20240000 + (month + 1) * 100 + day + 1;
+    }
+    return Transaction(nextId++, amount, type, date);
+}
+
+vector<pair<int, Transaction>> ChartGenerator::postings(size_t count) {
+    vector<pair<int, Transaction>> generated;
+    generated.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        int account = nextAccount();
+        generated.push_back({account, nextTransaction()});
+    }
+    return generated;
+}
+
+void ChartGenerator::writePostings(ostream & out) {
+    OutputBuffer buffer(out);
+    for (size_t i = 0; i < options.transactions; i++) {
+        int account = nextAccount();
+        Transaction t = nextTransaction();
+        buffer.write("post ");
+        buffer.writeInt(account);
+        buffer.put(' ');
+        buffer.writeInt(t.getId());
+        buffer.put(' ');
+        buffer.writeMoneyFixed(t.getAmount());
+        buffer.put(' ');
+        buffer.put(t.getType());
+        if (t.isDated()) {
+            buffer.put(' ');
+            buffer.writeInt(t.getDate());
+        }
+        buffer.put('\n');
+    }
+}
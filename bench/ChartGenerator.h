@@ -0,0 +1,137 @@
+/*-- ChartGenerator.h --------------------------------------------------------
+
+  This header file defines the ChartGenerator class, which produces
+  synthetic charts of accounts and posting streams for benchmarks.
+
+  A chart of N accounts holds the account numbers 1..N. Every number's
+  parent is the number without its last digit, so the chart is a complete
+  ten-way tree below the nine top-level accounts, and it is written in
+  preorder (the order buildTreeFromFile links without searching).
+
+  Postings draw their account either uniformly or from a skewed
+  distribution in which the k-th most used account is chosen with
+  probability proportional to 1/k; the popular accounts are scattered over
+  the whole chart rather than being the lowest numbers. Transaction IDs
+  are 1..M in order, so they are unique across the whole stream. Dated
+  streams give every posting a uniformly drawn day of 2024.
+
+  Basic operations include:
+     - Listing the chart's account numbers
+     - Writing the chart as a text file
+     - Generating postings in memory or as batch "post" commands
+
+  Output depends only on the options and the seed.
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Transaction.h"
+
+using namespace std;
+
+/******** Options ********/
+struct GeneratorOptions {
+    size_t accounts = 1000;       // Accounts in the chart (1..accounts)
+    size_t transactions = 100000; // Postings in the stream
+    bool skewed = false;          // 1/k account popularity instead of uniform
+    bool dated = false;           // Postings carry a date in 2024
+    uint64_t seed = 1;            // Seed of every random choice
+};
+
+class ChartGenerator {
+private:
+    /******** Data Members ********/
+    GeneratorOptions options;   // What to generate
+    mt19937_64 random;          // Source of every random choice
+    uint64_t scatter;           // Odd multiplier that spreads popular ranks over the chart
+    int nextId;                 // ID of the next generated transaction
+
+    /******** Private Member Functions ********/
+    uint64_t below(uint64_t bound);
+    /*----------------------------------------------------------------------
+    Draw a uniform integer.
+
+    Precondition:  bound > 0.
+    Postcondition: Returns a value in [0, bound).
+    -----------------------------------------------------------------------*/
+
+    void appendPreorder(int number, vector<int> &numbers) const;
+    /*----------------------------------------------------------------------
+    Append an account and its descendants in preorder.
+
+    Precondition:  1 <= number <= options.accounts.
+    Postcondition: number and every account below it are appended.
+    -----------------------------------------------------------------------*/
+
+public:
+    /******** Constructors ********/
+    explicit ChartGenerator(const GeneratorOptions &options);
+    /*----------------------------------------------------------------------
+    Construct a generator.
+
+    Precondition:  options.accounts is between 1 and 2^31 - 1.
+    Postcondition: The generator is seeded with options.seed; the next
+    transaction ID is 1.
+    -----------------------------------------------------------------------*/
+
+    /******** Charts ********/
+    vector<int> accountNumbers() const;
+    /*----------------------------------------------------------------------
+    Get the chart's account numbers.
+
+    Precondition:  None.
+    Postcondition: Returns 1..options.accounts in preorder.
+    -----------------------------------------------------------------------*/
+
+    void writeChart(ostream &out);
+    /*----------------------------------------------------------------------
+    Write the chart in the input format of buildTreeFromFile.
+
+    Precondition:  out is open.
+    Postcondition: One "NUMBER Account NUMBER BALANCE" line is written per
+    account, in preorder, with a random opening balance.
+    -----------------------------------------------------------------------*/
+
+    /******** Postings ********/
+    int nextAccount();
+    /*----------------------------------------------------------------------
+    Draw the account of a posting.
+
+    Precondition:  None.
+    Postcondition: Returns an account number of the chart, drawn from the
+    configured distribution.
+    -----------------------------------------------------------------------*/
+
+    Transaction nextTransaction();
+    /*----------------------------------------------------------------------
+    Generate the transaction of a posting.
+
+    Precondition:  None.
+    Postcondition: Returns a transaction with the next ID, an amount
+    between 0.01 and 1000.00, a random type and, if options.dated, a
+    random date in 2024.
+    -----------------------------------------------------------------------*/
+
+    vector<pair<int, Transaction>> postings(size_t count);
+    /*----------------------------------------------------------------------
+    Generate postings in memory.
+
+    Precondition:  None.
+    Postcondition: Returns count (account number, transaction) pairs.
+    -----------------------------------------------------------------------*/
+
+    void writePostings(ostream &out);
+    /*----------------------------------------------------------------------
+    Write the posting stream as batch commands.
+
+    Precondition:  out is open.
+    Postcondition: options.transactions "post ACCOUNT ID AMOUNT D|C" lines,
+    followed by the date if options.dated, are written (see BatchRunner.h).
+    -----------------------------------------------------------------------*/
+};
@@ -0,0 +1,89 @@
+/**
+ * @file GenerateChart.cpp
+ * @brief Writes a synthetic chart of accounts and posting stream.
+ *
+ * Usage: chart_generate [--accounts N] [--transactions M] [--skewed] [--dated]
+ *                       [--seed S] [--chart FILE] [--postings FILE|-]
+ *
+ * The chart can be loaded with the menu or the batch "load" command; the
+ * postings are batch "post" commands, so a run looks like
+ *
+ *     chart_generate --accounts 1000000 --chart big.txt --postings posts.txt
+ *     (echo "load big.txt"; cat posts.txt) | chart --batch -
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "ChartGenerator.h"
+
+using namespace std;
+
+static bool parseCount(const char *text, size_t &value) {
+    try {
+        size_t end;
+        unsigned long long parsed = stoull(text, &end);
+        value = parsed;
+        return text[end] == '\0';
+    } catch (const exception &) {
+        return false;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    GeneratorOptions options;
+    string chartFile, postingsFile;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++) {
+        string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        size_t value = 0;
+        if (option == "--skewed") {
+            options.skewed = true;
+        } else if (option == "--dated") {
+            options.dated = true;
+        } else if (!hasValue) {
+            valid = false;
+        } else if (option == "--accounts") {
+            valid = parseCount(argv[++i], options.accounts) && options.accounts >= 1 &&
+                    options.accounts <= 2147483647;
+        } else if (option == "--transactions") {
+            valid = parseCount(argv[++i], options.transactions) && options.transactions <= 2147483647;
+        } else if (option == "--seed") {
+            valid = parseCount(argv[++i], value);
+            options.seed = value;
+        } else if (option == "--chart") {
+            chartFile = argv[++i];
+        } else if (option == "--postings") {
+            postingsFile = argv[++i];
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || (chartFile.empty() && postingsFile.empty())) {
+        cerr << "Usage: " << argv[0] << " [--accounts N] [--transactions M] [--skewed] [--dated]"
+             << " [--seed S] [--chart FILE] [--postings FILE|-]\n";
+        return 2;
+    }
+
+    ChartGenerator generator(options);
+    if (!chartFile.empty()) {
+        ofstream out(chartFile, ios::binary);
+        generator.writeChart(out);
+        if (!out) {
+            cerr << "Error: Could not write " << chartFile << endl;
+            return 1;
+        }
+    }
+    if (postingsFile == "-") {
+        generator.writePostings(cout);
+    } else if (!postingsFile.empty()) {
+        ofstream out(postingsFile, ios::binary);
+        generator.writePostings(out);
+        if (!out) {
+            cerr << "Error: Could not write " << postingsFile << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -45,17 +45,84 @@
    - Supports creating and maintaining hierarchical account structures.
    - Tracks transactions for accounts and ensures updates propagate
      to parent accounts in the hierarchy.
+   - Batch mode: "chart --batch FILE [--quiet]" runs a command file (or
+     standard input for "-") without the menu; see BatchRunner.h.
 --------------------------------------------------------------------------------*/
 
 #include <iostream>
 #include <string>
 #include "ForestTree.h"
+#include "BatchRunner.h"
 
 using namespace std;
 
-int main() {
+/**
+ * Prints the diagnostics reported by the core classes to the console.
+ */
+class ConsoleDiagnostics : public DiagnosticSink {
+public:
+    void report(Status, const string &message) override {
+        cerr << message << '\n';
+    }
+};
+
+/**
+ * Prompts for the fields of a transaction until each one is valid.
+ */
+static Transaction readTransaction(istream &in) {
+    int id;
+    do {
+        cout << "Enter transaction ID: ";
+        in >> id;
+    } while (id <= 0);
+
+    Money amount;
+    do {
+        cout << "Enter transaction amount: ";
+        in >> amount;
+    } while (amount < Money());
+
+    Transaction trans(id, amount, 'D');
+    cout << "Enter transaction type (D for debit, C for credit): ";
+    char type;
+    in >> type;
+    while (!trans.setType(type)) {
+        cerr << "Invalid transaction type! Use 'D' for debit or 'C' for credit!!\n";
+        cout << "Re-enter transaction type (D or C): ";
+        in >> type;
+    }
+    return trans;
+}
+
+int main(int argc, char *argv[]) {
+
+    ConsoleDiagnostics console;
+    setDiagnosticSink(&console);
 
     ForestTree forest;
+    forest.setReportThreads(0);    // Render whole-tree reports on every core
+
+    /**
+     * Batch mode: run a command file instead of the interactive menu,
+     * then print a summary of what was done.
+     */
+    if (argc > 1) {
+        string mode = argv[1];
+        bool quiet = argc == 4 && string(argv[3]) == "--quiet";
+        if (mode != "--batch" || argc < 3 || (argc == 4 && !quiet) || argc > 4) {
+            cerr << "Usage: " << argv[0] << " [--batch FILE|- [--quiet]]\n";
+            return 2;
+        }
+        BatchRunner runner(forest, quiet ? BatchOutput::Quiet : BatchOutput::Buffered);
+        if (!runner.runFile(argv[2])) {
+            cerr << "Error: Could not open command file " << argv[2] << endl;
+            return 1;
+        }
+        runner.printSummary(cout);
+        const BatchSummary & summary = runner.getSummary();
+        return summary.invalidLines == 0 && summary.failed == 0 ? 0 : 1;
+    }
+
     int choice;
 
     do {
@@ -106,7 +173,7 @@ int main() {
             case 2: {
                 do {
                     int number;
-                    double balance;
+                    Money balance;
                     string description;
 
                     do {
@@ -120,7 +187,7 @@ int main() {
                     cin.ignore();
                     getline(cin, description);
 
-                    if (forest.addAccount(number, description, balance)) {
+                    if (forest.addAccount(number, description, balance) == Status::Ok) {
                         cout << "Account added successfully!\n";
                     }
 
@@ -152,8 +219,7 @@ int main() {
                     cin >> operation;
 
                     if (operation == "add") {
-                        Transaction newTransaction;
-                        cin >> newTransaction;
+                        Transaction newTransaction = readTransaction(cin);
                         forest.addAcountTransaction(accNumber, newTransaction);
                     } else if (operation == "delete") {
                         int transId;
@@ -162,7 +228,9 @@ int main() {
                             cin >> transId;
                         } while (transId <= 0);
 
-                        forest.removeAccountTransaction(accNumber, transId);
+                        if (forest.removeAccountTransaction(accNumber, transId) == Status::Ok) {
+                            cout << "Transaction successfully removed!!\n";
+                        }
                     } else {
                         cout << "Invalid operation! Please enter 'add' or 'delete'.\n";
                     }
@@ -185,7 +253,9 @@ int main() {
                     int accNumber;
                     cout << "Enter the account number for the detailed report: ";
                     cin >> accNumber;
-                    forest.printAccount(accNumber);
+                    if (forest.printAccount(accNumber) == Status::Ok) {
+                        cout << "File printed successfully!!\n";
+                    }
                     string repeat;
                     cout << "Do you want to print another detailed report? (yes/no): ";
                     cin >> repeat;
@@ -205,7 +275,7 @@ int main() {
                     int accNumber;
                     cout << "Enter the account number to search: ";
                     cin >> accNumber;
-                    forest.findAccount(accNumber);
+                    forest.findAccount(accNumber, cout);
 
                     string repeat;
                     cout << "Do you want to search for another account? (yes/no): ";
@@ -0,0 +1,217 @@
+/**
+ * @file ConcurrencyTest.cpp
+ * @brief Stress test of concurrent posting against a sequential oracle.
+ *
+ * Several threads post, remove, batch-post and add accounts on a tree in
+ * concurrent mode while others read balances, dated balances and subtree
+ * queries. Every writer's operations touch only its own transaction IDs,
+ * so the final tree does not depend on how the threads interleaved: it
+ * must equal an eager tree that ran the same operations one thread after
+ * another, in balances, histories, reports and audit. One subtree only
+ * ever receives postings dated after EARLY_DATE, so its balance as of
+ * that date must stay at zero while they arrive.
+ */
+
+#include <random>
+#include <thread>
+#include <atomic>
+#include "TestSupport.h"
+
+// One write operation of a writer thread
+struct Operation {
+    enum Kind { Post, Remove, RemoveById, Batch, NewAccount } kind;
+    int account;                                // Post, Remove, NewAccount
+    Transaction transaction;                    // Post; Remove and RemoveById use its ID
+    vector<pair<int, Transaction>> batch;       // Batch
+};
+
+static const int WRITERS = 5;
+static const int BATCH_WRITER = 3;             // Posts in batches and adds accounts
+static const int DATED_WRITER = 4;             // Posts to the dated subtree only
+static const int OPERATIONS = 2500;            // Per posting writer
+static const int POSTED_ACCOUNTS[] = {1, 11, 111, 112, 12, 121, 2, 21, 211, 3, 31};
+static const int NEW_ACCOUNTS[] = {113, 1121, 1122, 122, 212, 2111, 32, 311, 4, 41};
+static const int DATED_ACCOUNTS[] = {5, 51, 52, 521};
+static const int EARLY_DATE = 20240101;        // Before every posting to the dated subtree
+
+static Transaction randomPosting(mt19937 &random, int id) {
+    int date = random() % 2 == 0 ? 0 : 20240101 + (int)(random() % 12) * 100 + (int)(random() % 28);
+    return Transaction(id, Money::fromCents(1 + random() % 100000), random() % 3 == 0 ? 'C' : 'D', date);
+}
+
+// Writer w posts and removes IDs in its own range; the batch writer adds
+// accounts too, posting to each one it added
+static vector<Operation> writerOperations(int w) {
+    mt19937 random(1000 + w);
+    vector<Operation> ops;
+    int nextId = 1000000 * (w + 1);
+    vector<pair<int, int>> live;   // (account, ID) posted and not yet removed
+    if (w == BATCH_WRITER) {
+        for (int round = 0; round < 40; round++) {
+            Operation batch{Operation::Batch, 0, Transaction(), {}};
+            for (int i = 0; i < 60; i++) {
+                int account = POSTED_ACCOUNTS[random() % size(POSTED_ACCOUNTS)];
+                batch.batch.push_back({account, randomPosting(random, nextId++)});
+            }
+            // A repeated ID and a missing account are rejected in the batch
+            batch.batch.push_back({1, batch.batch.front().second});
+            batch.batch.push_back({999, randomPosting(random, nextId++)});
+            ops.push_back(batch);
+            if (round % 4 == 0) {
+                int account = NEW_ACCOUNTS[round / 4];
+                ops.push_back({Operation::NewAccount, account, Transaction(), {}});
+                ops.push_back({Operation::Post, account, randomPosting(random, nextId++), {}});
+            }
+        }
+        return ops;
+    }
+    for (int i = 0; i < OPERATIONS; i++) {
+        if (!live.empty() && random() % 4 == 0) {
+            size_t pick = random() % live.size();
+            Operation::Kind kind = random() % 2 == 0 ? Operation::Remove : Operation::RemoveById;
+            ops.push_back({kind, live[pick].first, Transaction(live[pick].second), {}});
+            live[pick] = live.back();
+            live.pop_back();
+        } else if (w == DATED_WRITER) {
+            int account = DATED_ACCOUNTS[random() % size(DATED_ACCOUNTS)];
+            int date = EARLY_DATE + 100 + (int)(random() % 28);
+            Transaction t(nextId, Money::fromCents(1 + random() % 100000), random() % 3 == 0 ? 'C' : 'D', date);
+            ops.push_back({Operation::Post, account, t, {}});
+            live.push_back({account, nextId++});
+        } else {
+            int account = POSTED_ACCOUNTS[random() % size(POSTED_ACCOUNTS)];
+            ops.push_back({Operation::Post, account, randomPosting(random, nextId), {}});
+            live.push_back({account, nextId++});
+        }
+    }
+    return ops;
+}
+
+static bool apply(ForestTree &tree, const Operation &op) {
+    switch (op.kind) {
+        case Operation::Post:
+            return tree.addAcountTransaction(op.account, op.transaction) == Status::Ok;
+        case Operation::Remove:
+            return tree.removeAccountTransaction(op.account, op.transaction.getId()) == Status::Ok;
+        case Operation::RemoveById:
+            return tree.removeTransaction(op.transaction.getId()) == Status::Ok;
+        case Operation::Batch: {
+            vector<PostStatus> results = tree.postBatch(op.batch);
+            size_t posted = count(results.begin(), results.end(), PostStatus::Posted);
+            return posted == op.batch.size() - 2 && results[op.batch.size() - 2] == PostStatus::DuplicateTransaction &&
+                   results.back() == PostStatus::AccountNotFound;
+        }
+        case Operation::NewAccount:
+            return tree.addAccount(op.account, "Added " + to_string(op.account), Money()) == Status::Ok;
+    }
+    return false;
+}
+
+// Every query the readers make, as one comparable line per account
+static string queryResults(const ForestTree &tree) {
+    ostringstream out;
+    vector<int> accounts(begin(POSTED_ACCOUNTS), end(POSTED_ACCOUNTS));
+    accounts.insert(accounts.end(), begin(NEW_ACCOUNTS), end(NEW_ACCOUNTS));
+    accounts.insert(accounts.end(), begin(DATED_ACCOUNTS), end(DATED_ACCOUNTS));
+    for (int number : accounts) {
+        Money balance, asOf, change;
+        tree.getAccountBalance(number, balance);
+        out << number << ' ' << balance;
+        for (int date : {EARLY_DATE, 20240201, 20240301, 20240615, 20241231}) {
+            tree.getBalanceAsOf(number, date, asOf);
+            tree.getBalanceChange(number, 20240201, date, change);
+            out << ' ' << asOf << ' ' << change;
+        }
+        BalanceSummary summary;
+        if (tree.summarizeAccounts(number, summary)) {
+            out << ' ' << summary.accounts << ' ' << summary.total;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+int main() {
+    setDiagnosticSink(nullptr);
+    TestRun run;
+    vector<vector<Operation>> operations;
+    for (int w = 0; w < WRITERS; w++) {
+        operations.push_back(writerOperations(w));
+    }
+
+    auto buildChart = [](ForestTree &tree) {
+        buildSampleChart(tree);
+        for (int number : DATED_ACCOUNTS) {
+            tree.addAccount(number, "Dated " + to_string(number), Money());
+        }
+    };
+
+    // The oracle runs every writer to the end, one after another
+    ForestTree oracle;
+    buildChart(oracle);
+    bool oracleApplied = true;
+    for (const auto &ops : operations) {
+        for (const Operation &op : ops) {
+            oracleApplied = apply(oracle, op) && oracleApplied;
+        }
+    }
+    run.check(oracleApplied, "every operation succeeds sequentially");
+
+    ForestTree tree;
+    tree.setConcurrent(true);
+    buildChart(tree);
+    atomic<int> failed(0);
+    atomic<int> earlyNonZero(0);
+    atomic<bool> writing(true);
+    atomic<long> reads(0);
+    vector<thread> writers, readers;
+    for (int w = 0; w < WRITERS; w++) {
+        writers.emplace_back([&, w] {
+            for (const Operation &op : operations[w]) {
+                if (!apply(tree, op)) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&, r] {
+            mt19937 random(r);
+            while (writing) {
+                int number = POSTED_ACCOUNTS[random() % size(POSTED_ACCOUNTS)];
+                Money balance;
+                BalanceSummary summary;
+                tree.getAccountBalance(number, balance);
+                tree.getBalanceAsOf(number, 20240601, balance);
+                tree.getBalanceChange(number, 20240101, 20241231, balance);
+                tree.summarizeAccounts(number, summary);
+                tree.topAccounts(number, 3);
+                tree.splitTransactions(number, 1, 5000000);
+                // Nothing in the dated subtree had happened yet on EARLY_DATE
+                int dated = DATED_ACCOUNTS[random() % size(DATED_ACCOUNTS)];
+                tree.getBalanceAsOf(dated, EARLY_DATE, balance);
+                if (balance != Money()) {
+                    earlyNonZero++;
+                }
+                reads++;
+            }
+        });
+    }
+    for (thread &t : writers) {
+        t.join();
+    }
+    writing = false;
+    for (thread &t : readers) {
+        t.join();
+    }
+
+    run.check(failed == 0, "every operation succeeds concurrently (" + to_string(failed) + " failed)");
+    run.check(reads > 0, "readers ran during the writes");
+    run.check(earlyNonZero == 0, "dated subtree is empty as of " + to_string(EARLY_DATE) + " at every read (" +
+                                     to_string(earlyNonZero) + " reads were not)");
+    run.check(queryResults(tree) == queryResults(oracle), "balances, dated balances and summaries match");
+    run.check(treeReport(tree) == treeReport(oracle), "full report matches");
+    run.check(tree.auditBalances().passed(), "audit of the concurrent tree passes");
+    run.check(oracle.auditBalances().passed(), "audit of the oracle passes");
+    return run.finish("concurrency_test");
+}
@@ -0,0 +1,46 @@
+/**
+ * @file ReportTest.cpp
+ * @brief Batch report export against single-account reports.
+ *
+ * exportAccountReports renders every account once and re-indents the
+ * renderings per report, so each file it writes must match, byte for
+ * byte, the one printAccount writes for the same account, including for
+ * descriptions that hold newlines or are cut off by the 10-character trim.
+ */
+
+#include <vector>
+#include "TestSupport.h"
+
+static const vector<int> ACCOUNTS = {1, 11, 111, 112, 12, 121, 122, 1221, 2, 21, 211, 3, 31};
+
+static void compareExports(TestRun &run, ForestTree &tree, unsigned threadCount) {
+    string label = to_string(threadCount) + " threads: ";
+    vector<string> printed;
+    for (int number : ACCOUNTS) {
+        run.check(tree.printAccount(number) == Status::Ok, label + "account " + to_string(number) + " printed");
+        printed.push_back(fileBytes("Print_results/Account " + to_string(number) + ".txt"));
+        remove(("Print_results/Account " + to_string(number) + ".txt").c_str());
+    }
+    tree.setReportThreads(threadCount);
+    run.check(tree.exportAccountReports(ACCOUNTS) == ACCOUNTS.size(), label + "every report exported");
+    for (size_t i = 0; i < ACCOUNTS.size(); i++) {
+        string exported = fileBytes("Print_results/Account " + to_string(ACCOUNTS[i]) + ".txt");
+        run.check(!exported.empty() && exported == printed[i],
+                  label + "export of account " + to_string(ACCOUNTS[i]) + " matches printAccount");
+    }
+}
+
+int main() {
+    setDiagnosticSink(nullptr);
+    TestRun run;
+    ForestTree tree;
+    buildSampleChart(tree);
+    // Newlines inside the trimmed description and past it
+    tree.addAccount(122, "\"Veh\nicles\"", Money::fromCents(0));
+    tree.addAccount(1221, "Trucks and\nvans\n", Money::fromCents(120000));
+    tree.addAcountTransaction(1221, Transaction(100, Money::fromCents(4550), 'C', 20240220));
+    tree.addAcountTransaction(122, Transaction(101, Money::fromCents(990), 'D', 0));
+    compareExports(run, tree, 1);
+    compareExports(run, tree, 3);
+    return run.finish("report_test");
+}
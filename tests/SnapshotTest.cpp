@@ -0,0 +1,120 @@
+/**
+ * @file SnapshotTest.cpp
+ * @brief Round trip and rejection tests of binary snapshots.
+ *
+ * A saved and restored tree must print exactly what the original does, in
+ * every balance mode, and damaged snapshots must be rejected with the
+ * right status without touching the tree they were loaded into.
+ */
+
+#include <cstddef>
+#include <functional>
+#include "TestSupport.h"
+
+// Writes a copy of a snapshot after damaging it; resum recomputes the
+// checksum so that only the damage itself can be detected
+static void writeDamaged(const string &bytes, const string &path, const function<void(string &)> &damage,
+                         bool resum) {
+    string copy = bytes;
+    damage(copy);
+    if (resum) {
+        SnapshotHeader header;
+        memcpy(&header, copy.data(), sizeof(header));
+        header.checksum = snapshotChecksum(copy.data() + sizeof(header), copy.size() - sizeof(header));
+        memcpy(&copy[0], &header, sizeof(header));
+    }
+    ofstream(path, ios::binary) << copy;
+}
+
+static void roundTrip(TestRun &run, const string &mode, const function<void(ForestTree &)> &configure) {
+    ForestTree saved;
+    configure(saved);
+    buildSampleChart(saved);
+    run.check(saved.saveSnapshot("round.bin"), mode + ": snapshot saved");
+    run.check(saved.printTreeIntoFile("saved_tree"), mode + ": saved tree printed");
+
+    ForestTree restored;
+    configure(restored);
+    run.check(restored.loadSnapshot("round.bin") == Status::Ok, mode + ": snapshot restored");
+    run.check(restored.printTreeIntoFile("restored_tree"), mode + ": restored tree printed");
+    run.check(fileBytes("Print_results/saved_tree.txt") == fileBytes("Print_results/restored_tree.txt"),
+              mode + ": printTreeIntoFile output matches");
+    run.check(treeReport(saved) == treeReport(restored), mode + ": operator<< output matches");
+    ostringstream flattened;
+    restored.snapshot().print(flattened);
+    run.check(flattened.str() == treeReport(saved), mode + ": ForestSnapshot prints the same report");
+
+    // Restored histories answer dated queries as the originals do
+    for (int number : {1, 11, 111, 112, 2, 211, 3}) {
+        for (int date : {20240101, 20240110, 20240118, 99991231}) {
+            Money before, after;
+            saved.getBalanceAsOf(number, date, before);
+            restored.getBalanceAsOf(number, date, after);
+            run.check(before == after, mode + ": balance of " + to_string(number) + " as of " + to_string(date));
+        }
+    }
+
+    // Saving the restored tree writes the same bytes
+    run.check(restored.saveSnapshot("again.bin"), mode + ": restored tree saved");
+    run.check(fileBytes("round.bin") == fileBytes("again.bin"), mode + ": snapshot bytes are stable");
+}
+
+static void rejections(TestRun &run) {
+    ForestTree source;
+    buildSampleChart(source);
+    source.saveSnapshot("good.bin");
+    string bytes = fileBytes("good.bin");
+    SnapshotHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    size_t accountsAt = sizeof(header);
+    size_t transactionsAt = accountsAt + header.accountCount * sizeof(SnapshotAccount);
+
+    writeDamaged(bytes, "checksum.bin", [&](string &copy) {
+        copy.back() ^= 1;
+    }, false);
+    writeDamaged(bytes, "version.bin", [&](string &copy) {
+        copy[offsetof(SnapshotHeader, version)]++;
+    }, false);
+    writeDamaged(bytes, "truncated.bin", [&](string &copy) {
+        copy.resize(transactionsAt + sizeof(SnapshotTransaction) / 2);
+    }, true);
+    writeDamaged(bytes, "account.bin", [&](string &copy) {
+        memcpy(&copy[accountsAt + sizeof(SnapshotAccount)], &copy[accountsAt], sizeof(int32_t));
+    }, true);
+    writeDamaged(bytes, "transaction.bin", [&](string &copy) {
+        size_t last = transactionsAt + (header.transactionCount - 1) * sizeof(SnapshotTransaction);
+        memcpy(&copy[last], &copy[transactionsAt], sizeof(int32_t));
+    }, true);
+
+    // The tree loaded into keeps its own contents through every rejection
+    ForestTree tree;
+    tree.addAccount(5, "Untouched", Money::fromCents(4200));
+    tree.addAcountTransaction(5, Transaction(1, Money::fromCents(100), 'D', 20240301));
+    string before = treeReport(tree);
+    const struct { const char *file; Status expected; } cases[] = {
+        {"missing.bin", Status::FileError},
+        {"checksum.bin", Status::ChecksumMismatch},
+        {"version.bin", Status::VersionMismatch},
+        {"truncated.bin", Status::InvalidFormat},
+        {"account.bin", Status::AccountExists},
+        {"transaction.bin", Status::TransactionExists},
+    };
+    for (const auto &c : cases) {
+        Status status = tree.loadSnapshot(c.file);
+        run.check(status == c.expected, string(c.file) + ": rejected with " + statusMessage(c.expected) +
+                                            ", got " + statusMessage(status));
+        run.check(treeReport(tree) == before, string(c.file) + ": tree left unchanged");
+    }
+    run.check(tree.loadSnapshot("good.bin") == Status::Ok && treeReport(tree) == treeReport(source),
+              "good.bin: accepted after the rejections");
+}
+
+int main() {
+    setDiagnosticSink(nullptr);
+    TestRun run;
+    roundTrip(run, "eager", [](ForestTree &) {});
+    roundTrip(run, "lazy", [](ForestTree &tree) { tree.setLazyBalances(true); });
+    roundTrip(run, "concurrent", [](ForestTree &tree) { tree.setConcurrent(true); });
+    rejections(run);
+    return run.finish("snapshot_test");
+}
@@ -0,0 +1,101 @@
+/*-- TestSupport.h -----------------------------------------------------------
+
+  This header file defines the helpers shared by the test programs in
+  tests/. Each test program is a plain executable registered with CTest;
+  it prints one line per failed check and exits non-zero if any failed.
+
+  Basic operations include:
+     - Checking: Count and report failed conditions
+     - Fixtures: Build a small chart with dated and undated postings
+     - Rendering: Capture a tree's report text or a file's bytes
+
+----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "ForestTree.h"
+
+using namespace std;
+
+/******** Checking ********/
+class TestRun {
+private:
+    /******** Data Members ********/
+    int checks = 0;             // Conditions checked
+    int failures = 0;           // Conditions that did not hold
+
+public:
+    void check(bool condition, const string &what) {
+        checks++;
+        if (!condition) {
+            failures++;
+            cout << "FAILED: " << what << '\n';
+        }
+    }
+    /*----------------------------------------------------------------------
+    Record one condition.
+
+    Precondition:  None.
+    Postcondition: If condition is false, what is printed and counted.
+    -----------------------------------------------------------------------*/
+
+    int finish(const string &name) const {
+        cout << name << ": " << checks - failures << " of " << checks << " checks passed\n";
+        return failures == 0 ? 0 : 1;
+    }
+    /*----------------------------------------------------------------------
+    Print the totals.
+
+    Precondition:  None.
+    Postcondition: Returns the exit status of the test program.
+    -----------------------------------------------------------------------*/
+};
+
+/******** Fixtures ********/
+inline void buildSampleChart(ForestTree &tree) {
+    const struct { int number; const char *description; int64_t cents; } accounts[] = {
+        {1, "Assets", 0}, {11, "Current Assets", 0}, {111, "Cash on hand", 150000},
+        {112, "Bank", 2500050}, {12, "Fixed Assets", 0}, {121, "Equipment", 990000},
+        {2, "Liabilities", 0}, {21, "Payables", -40000}, {211, "Suppliers", 0},
+        {3, "Equity", 0}, {31, "Capital", 10000000},
+    };
+    for (const auto &account : accounts) {
+        tree.addAccount(account.number, account.description, Money::fromCents(account.cents));
+    }
+    int id = 1;
+    for (int round = 0; round < 6; round++) {
+        for (int number : {111, 112, 121, 211, 31, 11}) {
+            int date = round % 2 == 0 ? 0 : 20240100 + round * 3 + number % 7;
+            tree.addAcountTransaction(number, Transaction(id, Money::fromCents(1234 * id + number),
+                                                          id % 3 == 0 ? 'C' : 'D', date));
+            id++;
+        }
+    }
+    tree.removeTransaction(5);
+}
+/*--------------------------------------------------------------------------
+Fill an empty tree with a three-level chart and 35 postings, some dated,
+some credits, one account holding postings while it has subaccounts.
+--------------------------------------------------------------------------*/
+
+/******** Rendering ********/
+inline string treeReport(const ForestTree &tree) {
+    ostringstream out;
+    out << tree;
+    return out.str();
+}
+/*--------------------------------------------------------------------------
+Get the text operator<< writes for a tree.
+--------------------------------------------------------------------------*/
+
+inline string fileBytes(const string &path) {
+    ifstream in(path, ios::binary);
+    return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+/*--------------------------------------------------------------------------
+Get the contents of a file, or "" if it cannot be read.
+--------------------------------------------------------------------------*/